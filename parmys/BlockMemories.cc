@@ -36,11 +36,15 @@
 
 #include "odin_util.h"
 #include <string.h>
+#include <vector>
 
 #include "BlockMemories.hpp"
+#include "ast_util.h"
 #include "hard_blocks.h"
 #include "memories.h"
 #include "netlist_utils.h"
+#include "odin_globals.h"
+#include "parmys_capacity.hpp"
 #include "node_creation_library.h"
 #include "partial_map.h"
 #include "vtr_memory.h"
@@ -50,6 +54,20 @@ using vtr::t_linked_vptr;
 /* global linked list including block memory instances */
 struct block_memory_information_t block_memories_info;
 
+/* LUTRAM inference statistics, reported once the block memories are mapped */
+static long lutram_memories = 0;
+static long lutram_tiles = 0;
+static long lutram_reclaimed_brams = 0;
+static long lutram_reclaimed_ffs = 0;
+
+/* read port replication statistics */
+static long replicated_memories = 0;
+static long replicated_banks = 0;
+
+/* small memory packing statistics */
+static long packed_memories = 0;
+static long packed_brams = 0;
+
 static block_memory_t *init_block_memory(nnode_t *node, netlist_t *netlist);
 
 void map_bram_to_mem_hardblocks(block_memory_t *bram, netlist_t *netlist);
@@ -65,6 +83,22 @@ static void create_2rw_dual_port_ram(block_memory_t *bram, netlist_t *netlist);
 static void create_2r2w_dual_port_ram(block_memory_t *bram, netlist_t *netlist);
 static void create_nrmw_dual_port_ram(block_memory_t *bram, netlist_t *netlist);
 
+static bool check_lutram_model(t_model *lutram_model);
+static void create_lutram(block_memory_t *memory, t_model *lutram_model, netlist_t *netlist);
+static long count_hard_memory_blocks(t_model *model, long depth, long width);
+
+static bool check_read_port_replication(block_memory_t *memory);
+static void create_nr_replicated_dual_port_rams(block_memory_t *memory, netlist_t *netlist);
+static void release_block_memory_pins(signal_list_t *signals, nnode_t *old_node);
+
+static bool check_packing_candidate(block_memory_t *memory, t_model *lutram_model);
+static bool check_same_memory_clock(block_memory_t *first, block_memory_t *second);
+static bool check_shared_address(block_memory_t *first, block_memory_t *second);
+static void pack_memory_width(block_memory_t *memory, block_memory_t *packed);
+static signal_list_t *stack_packed_address(block_memory_t *memory, int addr_width, bool upper_half, netlist_t *netlist);
+static void create_packed_dual_port_ram(block_memory_t *first, block_memory_t *second, netlist_t *netlist);
+static void pack_block_memories(netlist_t *netlist);
+
 static nnode_t *ymem_to_rom(nnode_t *node, uintptr_t traverse_mark_number);
 static nnode_t *ymem2_to_rom(nnode_t *node, uintptr_t traverse_mark_number);
 static nnode_t *ymem_to_bram(nnode_t *node, uintptr_t traverse_mark_number);
@@ -1063,8 +1097,7 @@ static void create_nrmw_dual_port_ram(block_memory_t *bram, netlist_t *netlist)
     int num_wr_ports = old_node->attributes->WR_PORTS;
 
     /* should have been resovled before this function */
-    oassert(num_rd_ports > 2);
-    oassert(num_wr_ports > 2);
+    oassert(num_rd_ports > 2 || num_wr_ports > 2);
 
     /* dual port ram signals */
     dp_ram_signals *signals = (dp_ram_signals *)vtr::calloc(1, sizeof(dp_ram_signals));
@@ -1130,6 +1163,774 @@ static void create_nrmw_dual_port_ram(block_memory_t *bram, netlist_t *netlist)
     free_dp_ram_signals(signals);
 }
 
+/**
+ * (function: release_block_memory_pins)
+ *
+ * @brief frees the pins of a block memory signal list that
+ * no new node took: pins still on the old node are deleted
+ * and loose fanout pins are detached from their nets
+ *
+ * @param signals list of signals (like read addr), may be NULL
+ * @param old_node pointer to the old node
+ */
+static void release_block_memory_pins(signal_list_t *signals, nnode_t *old_node)
+{
+    for (int i = 0; signals && i < signals->count; i++) {
+        npin_t *pin = signals->pins[i];
+        if (pin == NULL)
+            continue;
+
+        if (pin->node == old_node) {
+            delete_npin(pin);
+        } else if (pin->node == NULL && pin->net) {
+            remove_fanout_pin_unordered(pin->net, pin);
+            free_npin(pin);
+        }
+    }
+}
+
+/**
+ * (function: check_read_port_replication)
+ *
+ * @brief decides how a memory with more than two read ports is
+ * mapped, according to the -read_ports option. In auto mode, the
+ * memory is replicated when the extra DPRAMs the copies take,
+ * each worth -bram_lut_cost LUTs, cost no more than the read muxes
+ * of the multiplexed mapping, and the copies fit the device if its
+ * size is known. The multiplexed mapping cascades one mux per read
+ * port on every address bit and gates every read data bit of every
+ * port, so its muxes are counted as one LUT each.
+ *
+ * @param memory pointer to the rom or block memory
+ *
+ * @return whether the read ports should be replicated
+ */
+static bool check_read_port_replication(block_memory_t *memory)
+{
+    nnode_t *node = memory->node;
+    long rd_ports = node->attributes->RD_PORTS;
+    long wr_ports = node->attributes->WR_PORTS;
+
+    if (dual_port_rams == NULL || global_args.read_port_mapping.value() == "mux")
+        return (false);
+    if (global_args.read_port_mapping.value() == "replicate")
+        return (true);
+
+    long depth = shift_left_value_with_overflow_check(0X1, node->attributes->ABITS, memory->loc);
+    long blocks = std::max(1L, count_hard_memory_blocks(dual_port_rams, depth, node->attributes->DBITS));
+
+    /* writable copies use one port for the broadcast write, roms read on both ports */
+    long copies = (wr_ports) ? rd_ports : (rd_ports + 1) / 2;
+
+    if (hard_block_capacity.memories >= 0 && copies * blocks > hard_block_capacity.memories)
+        return (false);
+
+    long mux_luts = rd_ports * (node->attributes->ABITS + node->attributes->DBITS);
+    long extra_brams = (copies - 1) * blocks;
+
+    return (extra_brams * global_args.bram_lut_cost <= mux_luts);
+}
+
+/**
+ * (function: create_nr_replicated_dual_port_rams)
+ *
+ * @brief maps a memory with more than two read ports onto
+ * copies of the memory, so every read port keeps its own
+ * single cycle access. A rom takes ceil(R/2) DPRAMs reading
+ * on both ports. A block memory takes one DPRAM per read port,
+ * reading on the first port while the second one takes the
+ * writes, which are broadcast to all copies.
+ *
+ * @param memory pointer to the rom or block memory
+ * @param netlist pointer to the current netlist file
+ */
+static void create_nr_replicated_dual_port_rams(block_memory_t *memory, netlist_t *netlist)
+{
+    int i;
+    nnode_t *old_node = memory->node;
+    int data_width = old_node->attributes->DBITS;
+    int addr_width = old_node->attributes->ABITS;
+    int num_rd_ports = old_node->attributes->RD_PORTS;
+    int num_wr_ports = old_node->attributes->WR_PORTS;
+
+    /* validation */
+    oassert(num_rd_ports > 2);
+    oassert(memory->read_addr->count == num_rd_ports * addr_width);
+    oassert(memory->read_data->count == num_rd_ports * data_width);
+
+    /* the write port shared by all copies, muxed if there are several */
+    signal_list_t *write_addr = NULL;
+    signal_list_t *write_data = NULL;
+    signal_list_t *write_en = NULL;
+    signal_list_t *vcc_signals = NULL;
+    if (num_wr_ports == 1) {
+        write_addr = memory->write_addr;
+        write_data = memory->write_data;
+        write_en = init_signal_list();
+        add_pin_to_signal_list(write_en, memory->write_en->pins[0]);
+    } else if (num_wr_ports > 1) {
+        signal_list_t *selectors = copy_input_signals(memory->write_en);
+        write_addr = split_cascade_port(memory->write_addr, selectors, addr_width, old_node, netlist);
+        free_signal_list(selectors);
+
+        selectors = copy_input_signals(memory->write_en);
+        write_data = split_cascade_port(memory->write_data, selectors, data_width, old_node, netlist);
+        free_signal_list(selectors);
+
+        /* create vcc signas as the value of we when the write_en pins are active */
+        vcc_signals = init_signal_list();
+        for (i = 0; i < num_wr_ports; ++i) {
+            add_pin_to_signal_list(vcc_signals, get_one_pin(netlist));
+        }
+        write_en = split_cascade_port(vcc_signals, memory->write_en, 1, old_node, netlist);
+    }
+
+    int ports_per_copy = (num_wr_ports) ? 1 : 2;
+    for (int port = 0; port < num_rd_ports; port += ports_per_copy) {
+        dp_ram_signals *signals = (dp_ram_signals *)vtr::calloc(1, sizeof(dp_ram_signals));
+
+        /* the first port reads */
+        signals->addr1 = init_signal_list();
+        signals->data1 = init_signal_list();
+        signals->out1 = init_signal_list();
+        for (i = 0; i < addr_width; ++i) {
+            add_pin_to_signal_list(signals->addr1, memory->read_addr->pins[port * addr_width + i]);
+        }
+        for (i = 0; i < data_width; ++i) {
+            add_pin_to_signal_list(signals->data1, get_pad_pin(netlist));
+            add_pin_to_signal_list(signals->out1, memory->read_data->pins[port * data_width + i]);
+        }
+        signals->we1 = get_zero_pin(netlist);
+
+        /* the second port takes the writes, or reads the next port of a rom */
+        if (num_wr_ports) {
+            signals->addr2 = copy_input_signals(write_addr);
+            signals->data2 = copy_input_signals(write_data);
+            signals->we2 = copy_input_npin(write_en->pins[0]);
+            signals->out2 = NULL;
+        } else {
+            /* an odd last read port leaves the second port reading the same address */
+            int second = (port + 1 < num_rd_ports) ? port + 1 : -1;
+            signals->addr2 = init_signal_list();
+            signals->data2 = init_signal_list();
+            for (i = 0; i < addr_width; ++i) {
+                npin_t *addr_pin = memory->read_addr->pins[port * addr_width + i];
+                add_pin_to_signal_list(signals->addr2, (second >= 0) ? memory->read_addr->pins[second * addr_width + i] : copy_input_npin(addr_pin));
+            }
+            for (i = 0; i < data_width; ++i) {
+                add_pin_to_signal_list(signals->data2, get_pad_pin(netlist));
+            }
+            signals->we2 = get_zero_pin(netlist);
+
+            signals->out2 = NULL;
+            if (second >= 0) {
+                signals->out2 = init_signal_list();
+                for (i = 0; i < data_width; ++i) {
+                    add_pin_to_signal_list(signals->out2, memory->read_data->pins[second * data_width + i]);
+                }
+            }
+        }
+
+        signals->clk = copy_input_npin(memory->clk->pins[0]);
+
+        /* create a new dual port ram */
+        create_dual_port_ram(signals, old_node);
+        replicated_banks++;
+
+        free_dp_ram_signals(signals);
+    }
+    replicated_memories++;
+
+    // CLEAN UP the pins of the old node only copies were taken from
+    release_block_memory_pins(memory->read_en, old_node);
+    release_block_memory_pins(memory->clk, old_node);
+    release_block_memory_pins(write_addr, old_node);
+    release_block_memory_pins(write_data, old_node);
+    release_block_memory_pins(write_en, old_node);
+    if (num_wr_ports == 0)
+        release_block_memory_pins(memory->write_data, old_node);
+
+    if (write_addr != memory->write_addr)
+        free_signal_list(write_addr);
+    if (write_data != memory->write_data)
+        free_signal_list(write_data);
+    free_signal_list(write_en);
+    free_signal_list(vcc_signals);
+
+    cleanup_block_memory_old_node(old_node);
+}
+
+/**
+ * (function: check_packing_candidate)
+ *
+ * @brief checks the memory may share its block ram with other
+ * small memories: it has a single read port and at most one
+ * write port on the same address, and is not left to soft
+ * logic or LUTRAMs
+ *
+ * @param memory pointer to the rom or block memory
+ * @param lutram_model pointer to the usable lutram model, or NULL
+ *
+ * @return whether the memory can be packed
+ */
+static bool check_packing_candidate(block_memory_t *memory, t_model *lutram_model)
+{
+    nnode_t *node = memory->node;
+
+    if (node->attributes->RD_PORTS != 1 || node->attributes->WR_PORTS > 1)
+        return (false);
+    if (node->attributes->WR_PORTS == 1 && !check_same_addrs(memory))
+        return (false);
+
+    long depth = shift_left_value_with_overflow_check(0X1, node->attributes->ABITS, memory->loc);
+    long width = node->attributes->DBITS;
+
+    if (depth <= configuration.soft_logic_memory_depth_threshold && width <= configuration.soft_logic_memory_width_threshold)
+        return (false);
+    if (lutram_model != NULL && LUTRAM_INFERENCE_THRESHOLD_MIN <= depth * width && depth * width <= LUTRAM_INFERENCE_THRESHOLD_MAX)
+        return (false);
+
+    /* the block ram model is needed to tell whether packing saves blocks */
+    return (count_hard_memory_blocks(single_port_rams, depth, width) > 0);
+}
+
+/**
+ * (function: check_same_memory_clock)
+ *
+ * @brief checks two memories are clocked by the same signal
+ * with the same read and write clock settings
+ *
+ * @param first pointer to the first memory
+ * @param second pointer to the second memory
+ *
+ * @return whether the memories can share a block ram clock
+ */
+static bool check_same_memory_clock(block_memory_t *first, block_memory_t *second)
+{
+    attr_t *first_attr = first->node->attributes;
+    attr_t *second_attr = second->node->attributes;
+
+    return (sigcmp(first->clk, second->clk) && first_attr->RD_CLK_ENABLE == second_attr->RD_CLK_ENABLE
+            && first_attr->RD_CLK_POLARITY == second_attr->RD_CLK_POLARITY && first_attr->WR_CLK_POLARITY == second_attr->WR_CLK_POLARITY);
+}
+
+/**
+ * (function: check_shared_address)
+ *
+ * @brief checks two memories are read and written at the
+ * same address, so their data can be placed side by side
+ *
+ * @param first pointer to the first memory
+ * @param second pointer to the second memory
+ *
+ * @return whether the memories share their address
+ */
+static bool check_shared_address(block_memory_t *first, block_memory_t *second)
+{
+    nnode_t *first_node = first->node;
+    nnode_t *second_node = second->node;
+
+    if (first_node->attributes->ABITS != second_node->attributes->ABITS || first_node->attributes->WR_PORTS != second_node->attributes->WR_PORTS)
+        return (false);
+    if (!check_same_memory_clock(first, second) || !sigcmp(first->read_addr, second->read_addr))
+        return (false);
+
+    return (first_node->attributes->WR_PORTS == 0 || sigcmp(first->write_en, second->write_en));
+}
+
+/**
+ * (function: pack_memory_width)
+ *
+ * @brief appends the data of the packed memory to the given
+ * memory, which shares its address. The address, enable and
+ * clock pins of the packed memory are dropped; its node is
+ * freed once the given memory is mapped.
+ *
+ * @param memory pointer to the memory taking the data
+ * @param packed pointer to the memory being packed
+ */
+static void pack_memory_width(block_memory_t *memory, block_memory_t *packed)
+{
+    int i;
+    for (i = 0; i < packed->read_data->count; ++i) {
+        add_pin_to_signal_list(memory->read_data, packed->read_data->pins[i]);
+    }
+    for (i = 0; i < packed->write_data->count; ++i) {
+        add_pin_to_signal_list(memory->write_data, packed->write_data->pins[i]);
+    }
+    memory->node->attributes->DBITS += packed->node->attributes->DBITS;
+
+    release_block_memory_pins(packed->read_addr, packed->node);
+    release_block_memory_pins(packed->read_en, packed->node);
+    release_block_memory_pins(packed->write_addr, packed->node);
+    release_block_memory_pins(packed->write_en, packed->node);
+    release_block_memory_pins(packed->clk, packed->node);
+}
+
+/**
+ * (function: stack_packed_address)
+ *
+ * @brief builds the address of a memory stacked into one half
+ * of a dual port ram: its read address, zero padded to the
+ * address width, with the half select bit on top
+ *
+ * @param memory pointer to the rom or block memory
+ * @param addr_width address width of the larger memory
+ * @param upper_half whether the memory takes the upper half
+ * @param netlist pointer to the current netlist file
+ *
+ * @return the dual port ram address signals
+ */
+static signal_list_t *stack_packed_address(block_memory_t *memory, int addr_width, bool upper_half, netlist_t *netlist)
+{
+    signal_list_t *addr = init_signal_list();
+    for (int i = 0; i < addr_width; ++i) {
+        add_pin_to_signal_list(addr, (i < memory->read_addr->count) ? memory->read_addr->pins[i] : get_zero_pin(netlist));
+    }
+    add_pin_to_signal_list(addr, (upper_half) ? get_one_pin(netlist) : get_zero_pin(netlist));
+
+    return (addr);
+}
+
+/**
+ * (function: create_packed_dual_port_ram)
+ *
+ * @brief stacks two memories of the same width into one dual
+ * port ram. Each memory takes one port and one half of the
+ * depth, selected by an extra address bit tied to the port.
+ *
+ * @param first pointer to the memory taking the first port
+ * @param second pointer to the memory taking the second port
+ * @param netlist pointer to the current netlist file
+ */
+static void create_packed_dual_port_ram(block_memory_t *first, block_memory_t *second, netlist_t *netlist)
+{
+    nnode_t *first_node = first->node;
+    nnode_t *second_node = second->node;
+    int addr_width = std::max(first_node->attributes->ABITS, second_node->attributes->ABITS);
+
+    /* validation */
+    oassert(first_node->attributes->DBITS == second_node->attributes->DBITS);
+    oassert(first->read_data->count == second->read_data->count);
+
+    /* dual port ram signals */
+    dp_ram_signals *signals = (dp_ram_signals *)vtr::calloc(1, sizeof(dp_ram_signals));
+
+    /* the first memory takes the lower half */
+    signals->addr1 = stack_packed_address(first, addr_width, false, netlist);
+    signals->data1 = first->write_data;
+    signals->we1 = (first_node->attributes->WR_PORTS) ? first->write_en->pins[0] : get_zero_pin(netlist);
+    signals->out1 = first->read_data;
+
+    /* the second memory takes the upper half */
+    signals->addr2 = stack_packed_address(second, addr_width, true, netlist);
+    signals->data2 = second->write_data;
+    signals->we2 = (second_node->attributes->WR_PORTS) ? second->write_en->pins[0] : get_zero_pin(netlist);
+    signals->out2 = second->read_data;
+
+    signals->clk = first->clk->pins[0];
+
+    /* create a new dual port ram */
+    create_dual_port_ram(signals, first_node);
+
+    // CLEAN UP the pins the dual port ram does not take, the write enables past the first included
+    release_block_memory_pins(first->read_en, first_node);
+    release_block_memory_pins(first->write_addr, first_node);
+    release_block_memory_pins(first->write_en, first_node);
+    release_block_memory_pins(second->read_en, second_node);
+    release_block_memory_pins(second->write_addr, second_node);
+    release_block_memory_pins(second->write_en, second_node);
+    release_block_memory_pins(second->clk, second_node);
+
+    cleanup_block_memory_old_node(first_node);
+    cleanup_block_memory_old_node(second_node);
+
+    free_signal_list(signals->addr1);
+    free_signal_list(signals->addr2);
+    vtr::free(signals);
+}
+
+/**
+ * (function: pack_block_memories)
+ *
+ * @brief packs small memories that would each take a block
+ * ram of their own into shared ones. Memories sharing their
+ * address and clock are placed side by side in one single
+ * port ram; other pairs of memories of the same width and
+ * clock are stacked into the two halves of one dual port ram.
+ * Memories are only packed when it takes fewer block rams.
+ * The packed memories are mapped here and their nodes are
+ * cleared, so they are skipped by the regular mapping.
+ *
+ * @param netlist pointer to the current netlist file
+ */
+static void pack_block_memories(netlist_t *netlist)
+{
+    size_t i, j;
+    t_model *lutram_model = find_hard_block(LUTRAM_string);
+    if (lutram_model != NULL && !check_lutram_model(lutram_model))
+        lutram_model = NULL;
+
+    std::vector<block_memory_t *> candidates;
+    t_linked_vptr *lists[2] = {block_memories_info.block_memory_list, block_memories_info.read_only_memory_list};
+    for (t_linked_vptr *ptr : lists) {
+        for (; ptr != NULL; ptr = ptr->next) {
+            block_memory_t *memory = (block_memory_t *)ptr->data_vptr;
+            if (check_packing_candidate(memory, lutram_model))
+                candidates.push_back(memory);
+        }
+    }
+
+    std::vector<bool> packed(candidates.size(), false);
+
+    /* place memories sharing an address side by side */
+    for (i = 0; i < candidates.size(); ++i) {
+        block_memory_t *memory = candidates[i];
+        long depth = shift_left_value_with_overflow_check(0X1, memory->node->attributes->ABITS, memory->loc);
+
+        std::vector<block_memory_t *> side_by_side;
+        for (j = i + 1; j < candidates.size(); ++j) {
+            block_memory_t *other = candidates[j];
+            if (packed[j] || !check_shared_address(memory, other))
+                continue;
+
+            long width = memory->node->attributes->DBITS;
+            long other_width = other->node->attributes->DBITS;
+            if (count_hard_memory_blocks(single_port_rams, depth, width + other_width)
+                >= count_hard_memory_blocks(single_port_rams, depth, width) + count_hard_memory_blocks(single_port_rams, depth, other_width))
+                continue;
+
+            pack_memory_width(memory, other);
+            side_by_side.push_back(other);
+            packed[j] = true;
+        }
+
+        if (side_by_side.empty())
+            continue;
+
+        packed[i] = true;
+        packed_memories += side_by_side.size() + 1;
+        packed_brams += count_hard_memory_blocks(single_port_rams, depth, memory->node->attributes->DBITS);
+
+        if (memory->node->attributes->WR_PORTS)
+            create_rw_single_port_ram(memory, netlist);
+        else
+            create_r_single_port_ram(memory, netlist);
+        memory->node = NULL;
+
+        for (block_memory_t *other : side_by_side) {
+            cleanup_block_memory_old_node(other->node);
+            other->node = NULL;
+        }
+    }
+
+    if (dual_port_rams == NULL)
+        return;
+
+    /* stack pairs of the remaining memories into dual port rams */
+    for (i = 0; i < candidates.size(); ++i) {
+        if (packed[i])
+            continue;
+
+        block_memory_t *memory = candidates[i];
+        long depth = shift_left_value_with_overflow_check(0X1, memory->node->attributes->ABITS, memory->loc);
+        long width = memory->node->attributes->DBITS;
+
+        for (j = i + 1; j < candidates.size(); ++j) {
+            block_memory_t *other = candidates[j];
+            if (packed[j] || other->node->attributes->DBITS != width || !check_same_memory_clock(memory, other))
+                continue;
+
+            long other_depth = shift_left_value_with_overflow_check(0X1, other->node->attributes->ABITS, other->loc);
+            long stacked_blocks = count_hard_memory_blocks(dual_port_rams, 2 * std::max(depth, other_depth), width);
+            if (stacked_blocks
+                >= count_hard_memory_blocks(single_port_rams, depth, width) + count_hard_memory_blocks(single_port_rams, other_depth, width))
+                continue;
+
+            packed_memories += 2;
+            packed_brams += stacked_blocks;
+
+            create_packed_dual_port_ram(memory, other, netlist);
+            memory->node = NULL;
+            other->node = NULL;
+
+            packed[i] = packed[j] = true;
+            break;
+        }
+    }
+}
+
+/**
+ * (function: check_lutram_model)
+ *
+ * @brief checks the lutram model of the architecture has the
+ * ports LUTRAM inference relies on: a synchronous write port
+ * (waddr, data, we, clk) and an asynchronous read port (raddr,
+ * out), out as wide as data and raddr as wide as waddr
+ *
+ * @param lutram_model pointer to the lutram model
+ *
+ * @return whether memories can be mapped to the lutram model
+ */
+static bool check_lutram_model(t_model *lutram_model)
+{
+    t_model_ports *raddr = get_model_port(lutram_model->inputs, "raddr");
+    t_model_ports *waddr = get_model_port(lutram_model->inputs, "waddr");
+    t_model_ports *data = get_model_port(lutram_model->inputs, "data");
+    t_model_ports *out = get_model_port(lutram_model->outputs, "out");
+
+    if (raddr && waddr && data && out && get_model_port(lutram_model->inputs, "we") && get_model_port(lutram_model->inputs, "clk")
+        && raddr->size == waddr->size && data->size == out->size && raddr->size > 0 && data->size > 0)
+        return (true);
+
+    static bool warned = false;
+    if (!warned) {
+        warning_message(NETLIST, unknown_location,
+                        "%s model does not have the raddr/waddr/data/we/clk inputs and the out output of matching widths, LUTRAM inference is "
+                        "disabled\n",
+                        LUTRAM_string);
+        warned = true;
+    }
+    return (false);
+}
+
+/**
+ * (function: count_hard_memory_blocks)
+ *
+ * @brief estimates the single/dual port rams a memory takes,
+ * one per block depth times one per block data width
+ *
+ * @param model single_port_rams or dual_port_rams model
+ * @param depth memory depth
+ * @param width memory data width
+ *
+ * @return number of hard memory blocks, 0 if there are none
+ */
+static long count_hard_memory_blocks(t_model *model, long depth, long width)
+{
+    if (model == NULL)
+        return (0);
+
+    t_model_ports *addr = get_model_port(model->inputs, (model == single_port_rams) ? "addr" : "addr1");
+    t_model_ports *data = get_model_port(model->inputs, (model == single_port_rams) ? "data" : "data1");
+    if (addr == NULL || data == NULL || data->size <= 0)
+        return (0);
+
+    long block_depth = shift_left_value_with_overflow_check(0X1, std::min(addr->size, 30), unknown_location);
+    return (((depth + block_depth - 1) / block_depth) * ((width + data->size - 1) / data->size));
+}
+
+/**
+ * (function: create_lutram)
+ *
+ * @brief maps a rom or a block memory with at most one write port
+ * and within the LUTRAM thresholds to the lutram_ram model of the
+ * architecture, whose raddr and data widths give the depth and width
+ * of one lutram tile. The memory is split into banks as deep as the
+ * tile, selected by the upper address bits, and into slices as wide
+ * as the tile. LUTRAMs read asynchronously, so every read port gets
+ * its own copy of the banks, sharing the write signals, and the
+ * outputs of memories read synchronously are registered.
+ *
+ * @param memory pointer to the rom or block memory
+ * @param lutram_model pointer to the lutram model
+ * @param netlist pointer to the current netlist file
+ */
+static void create_lutram(block_memory_t *memory, t_model *lutram_model, netlist_t *netlist)
+{
+    int i, j;
+    nnode_t *old_node = memory->node;
+    int addr_width = old_node->attributes->ABITS;
+    int data_width = old_node->attributes->DBITS;
+    int num_rd_ports = old_node->attributes->RD_PORTS;
+    int num_wr_ports = old_node->attributes->WR_PORTS;
+
+    /* validation */
+    oassert(num_wr_ports <= 1);
+    oassert(memory->read_addr->count == num_rd_ports * addr_width);
+    oassert(memory->read_data->count == num_rd_ports * data_width);
+
+    int tile_addr_width = get_model_port(lutram_model->inputs, "raddr")->size;
+    int tile_width = get_model_port(lutram_model->inputs, "data")->size;
+
+    /* upper address bits select the bank, the rest address the tile */
+    int select_width = std::max(0, addr_width - tile_addr_width);
+    long num_banks = shift_left_value_with_overflow_check(0X1, select_width, old_node->loc);
+    int num_slices = (data_width + tile_width - 1) / tile_width;
+
+    /* without a read clock the memory is read asynchronously, like the LUTRAM itself */
+    bool sync_read = (old_node->attributes->RD_CLK_ENABLE != ACTIVE_LOW_SENSITIVITY);
+    edge_type_e read_edge = (old_node->attributes->RD_CLK_POLARITY == ACTIVE_LOW_SENSITIVITY) ? FALLING_EDGE_SENSITIVITY : RISING_EDGE_SENSITIVITY;
+
+    npin_t *clk = memory->clk->pins[0];
+    npin_t *we = (num_wr_ports) ? memory->write_en->pins[0] : NULL;
+
+    /* the write enable of every bank */
+    std::vector<nnet_t *> bank_we;
+    if (we)
+        bank_we = decode_address_banks(memory->write_addr, tile_addr_width, select_width, we, false, old_node, netlist);
+    else
+        bank_we.assign(num_banks, netlist->zero_net);
+
+    for (int port = 0; port < num_rd_ports; port++) {
+        npin_t *read_en = memory->read_en->pins[port];
+
+        /* the bank driving the read data */
+        std::vector<nnet_t *> bank_select;
+        if (num_banks > 1)
+            bank_select = decode_address_banks(memory->read_addr, port * addr_width + tile_addr_width, select_width, NULL, false, old_node, netlist);
+
+        /* tile outputs per bank, one net per data bit */
+        std::vector<std::vector<npin_t *>> bank_out(num_banks, std::vector<npin_t *>(data_width, NULL));
+
+        for (long bank = 0; bank < num_banks; bank++) {
+            for (int slice = 0; slice < num_slices; slice++) {
+                nnode_t *lutram = allocate_nnode(old_node->loc);
+                lutram->type = HARD_IP;
+                lutram->traverse_visited = old_node->traverse_visited;
+
+                char *hb_name = vtr::strdup(LUTRAM_string);
+                lutram->name = node_name(lutram, hb_name);
+                lutram->attributes->memory_id = vtr::strdup(old_node->attributes->memory_id);
+
+                /* Create a fake ast node. */
+                lutram->related_ast_node = create_node_w_type(RAM, old_node->loc);
+                lutram->related_ast_node->identifier_node = create_tree_node_id(hb_name, old_node->loc);
+
+                /* INPUTS */
+                signal_list_t *raddr = init_signal_list();
+                signal_list_t *waddr = init_signal_list();
+                for (i = 0; i < tile_addr_width; i++) {
+                    if (i < addr_width) {
+                        add_pin_to_signal_list(raddr, copy_input_npin(memory->read_addr->pins[port * addr_width + i]));
+                        add_pin_to_signal_list(waddr, (we) ? copy_input_npin(memory->write_addr->pins[i]) : get_zero_pin(netlist));
+                    } else {
+                        add_pin_to_signal_list(raddr, get_zero_pin(netlist));
+                        add_pin_to_signal_list(waddr, get_zero_pin(netlist));
+                    }
+                }
+
+                signal_list_t *data = init_signal_list();
+                for (i = 0; i < tile_width; i++) {
+                    int bit = slice * tile_width + i;
+                    add_pin_to_signal_list(data, (we && bit < data_width) ? copy_input_npin(memory->write_data->pins[bit]) : get_pad_pin(netlist));
+                }
+
+                signal_list_t *tile_we = init_signal_list();
+                add_pin_to_signal_list(tile_we, make_fanout_pin(bank_we[bank]));
+
+                signal_list_t *tile_clk = init_signal_list();
+                add_pin_to_signal_list(tile_clk, copy_input_npin(clk));
+
+                add_input_port_to_memory(lutram, raddr, "raddr");
+                add_input_port_to_memory(lutram, waddr, "waddr");
+                add_input_port_to_memory(lutram, data, "data");
+                add_input_port_to_memory(lutram, tile_we, "we");
+                add_input_port_to_memory(lutram, tile_clk, "clk");
+
+                /* OUTPUT */
+                signal_list_t *out = init_signal_list();
+                for (i = 0; i < tile_width; i++) {
+                    int bit = slice * tile_width + i;
+                    npin_t *out_pin = NULL;
+                    if (bit < data_width && num_banks == 1 && !sync_read) {
+                        /* drives the read data directly */
+                        out_pin = memory->read_data->pins[port * data_width + bit];
+                    } else {
+                        out_pin = allocate_npin();
+                        nnet_t *out_net = allocate_nnet();
+                        add_driver_pin_to_net(out_net, out_pin);
+                    }
+                    if (bit < data_width)
+                        bank_out[bank][bit] = out_pin;
+
+                    add_pin_to_signal_list(out, out_pin);
+                }
+                add_output_port_to_memory(lutram, out, "out");
+
+                /* register the lutram in arch model to have the related model in BLIF */
+                lutram_model->used = 1;
+                lutram_tiles++;
+
+                // CLEAN UP
+                free_signal_list(raddr);
+                free_signal_list(waddr);
+                free_signal_list(data);
+                free_signal_list(tile_we);
+                free_signal_list(tile_clk);
+                free_signal_list(out);
+            }
+        }
+
+        if (num_banks == 1 && !sync_read)
+            continue;
+
+        for (i = 0; i < data_width; i++) {
+            npin_t *read_data = memory->read_data->pins[port * data_width + i];
+
+            /* the read bank, picked by the upper address bits */
+            nnode_t *driver = NULL;
+            if (num_banks > 1) {
+                driver = make_2port_gate(MUX_2, num_banks, num_banks, 1, old_node, old_node->traverse_visited);
+                for (j = 0; j < num_banks; j++) {
+                    add_input_pin_to_node(driver, make_fanout_pin(bank_select[j]), j);
+                    add_input_pin_to_node(driver, make_fanout_pin(bank_out[j][i]->net), num_banks + j);
+                }
+            }
+
+            if (sync_read) {
+                nnode_t *ff = make_2port_gate(FF_NODE, 1, 1, 1, old_node, old_node->traverse_visited);
+                ff->attributes->clk_edge_type = read_edge;
+                remap_pin_to_new_node(read_data, ff, 0);
+                add_input_pin_to_node(ff, copy_input_npin(clk), 1);
+
+                nnet_t *value = bank_out[0][i]->net;
+                if (driver) {
+                    npin_t *driver_out = allocate_npin();
+                    value = allocate_nnet();
+                    add_output_pin_to_node(driver, driver_out, 0);
+                    add_driver_pin_to_net(value, driver_out);
+                }
+
+                if (read_en->net != netlist->one_net) {
+                    /* the read enable holds the registered data */
+                    nnode_t *hold = make_2port_gate(MUX_2, 2, 2, 1, old_node, old_node->traverse_visited);
+                    nnode_t *not_en = make_not_gate_with_input(copy_input_npin(read_en), old_node, old_node->traverse_visited);
+                    add_input_pin_to_node(hold, copy_input_npin(read_en), 0);
+                    connect_nodes(not_en, 0, hold, 1);
+                    add_input_pin_to_node(hold, make_fanout_pin(value), 2);
+                    add_input_pin_to_node(hold, make_fanout_pin(read_data->net), 3);
+
+                    connect_nodes(hold, 0, ff, 0);
+                } else {
+                    add_input_pin_to_node(ff, make_fanout_pin(value), 0);
+                }
+            } else {
+                remap_pin_to_new_node(read_data, driver, 0);
+            }
+        }
+    }
+
+    /* statistics of what the memory would have taken otherwise */
+    lutram_memories++;
+    long depth = shift_left_value_with_overflow_check(0X1, addr_width, old_node->loc);
+    long brams = count_hard_memory_blocks((single_port_rams) ? single_port_rams : dual_port_rams, depth, data_width);
+    if (brams && (depth > configuration.soft_logic_memory_depth_threshold || data_width > configuration.soft_logic_memory_width_threshold))
+        lutram_reclaimed_brams += brams;
+    else
+        lutram_reclaimed_ffs += depth * data_width;
+
+    // CLEAN UP the pins of the old node only copies were taken from
+    release_block_memory_pins(memory->read_addr, old_node);
+    release_block_memory_pins(memory->read_en, old_node);
+    release_block_memory_pins(memory->write_addr, old_node);
+    release_block_memory_pins(memory->write_data, old_node);
+    release_block_memory_pins(memory->write_en, old_node);
+    release_block_memory_pins(memory->clk, old_node);
+
+    cleanup_block_memory_old_node(old_node);
+}
+
 /**
  * (function: map_rom_to_mem_hardblocks)
  *
@@ -1155,10 +1956,10 @@ void map_rom_to_mem_hardblocks(block_memory_t *rom, netlist_t *netlist)
     int rom_relative_area = depth * width;
     t_model *lutram_model = find_hard_block(LUTRAM_string);
 
-    if (lutram_model != NULL && (LUTRAM_INFERENCE_THRESHOLD_MIN <= rom_relative_area) && (rom_relative_area <= LUTRAM_INFERENCE_THRESHOLD_MAX)) {
+    if (lutram_model != NULL && (LUTRAM_INFERENCE_THRESHOLD_MIN <= rom_relative_area) && (rom_relative_area <= LUTRAM_INFERENCE_THRESHOLD_MAX)
+        && check_lutram_model(lutram_model)) {
         /* map to LUTRAM */
-        // nnode_t* lutram = NULL;
-        /* TODO */
+        create_lutram(rom, lutram_model, netlist);
     } else {
         /* need to split the rom from the data width */
         if (rd_ports == 1) {
@@ -1169,6 +1970,10 @@ void map_rom_to_mem_hardblocks(block_memory_t *rom, netlist_t *netlist)
             /* create the ROM and allocate ports according to the DPRAM hard block */
             create_2r_dual_port_ram(rom, netlist);
 
+        } else if (check_read_port_replication(rom)) {
+            /* more than 2 read ports, each pair of them gets its own copy of the rom in a DPRAM */
+            create_nr_replicated_dual_port_rams(rom, netlist);
+
         } else {
             /* more than 2 read ports wil be handle using multiplexed ports and a SPRAM */
             create_nr_single_port_ram(rom, netlist);
@@ -1204,10 +2009,11 @@ void map_bram_to_mem_hardblocks(block_memory_t *bram, netlist_t *netlist)
     int bram_relative_area = depth * width;
     t_model *lutram_model = find_hard_block(LUTRAM_string);
 
-    if (lutram_model != NULL && (LUTRAM_INFERENCE_THRESHOLD_MIN <= bram_relative_area) && (bram_relative_area <= LUTRAM_INFERENCE_THRESHOLD_MAX)) {
+    /* LUTRAMs have a single write port, wider writes keep going to the block rams */
+    if (lutram_model != NULL && (LUTRAM_INFERENCE_THRESHOLD_MIN <= bram_relative_area) && (bram_relative_area <= LUTRAM_INFERENCE_THRESHOLD_MAX)
+        && wr_ports == 1 && check_lutram_model(lutram_model)) {
         /* map to LUTRAM */
-        // nnode_t* lutram = NULL;
-        /* TODO */
+        create_lutram(bram, lutram_model, netlist);
     } else {
         if (wr_ports == (rd_ports == 1)) {
             if (check_same_addrs(bram)) {
@@ -1231,6 +2037,10 @@ void map_bram_to_mem_hardblocks(block_memory_t *bram, netlist_t *netlist)
             /* create a dual port ram and allocate ports according to the DPRAM hard block */
             create_2r2w_dual_port_ram(bram, netlist);
 
+        } else if (rd_ports > 2 && check_read_port_replication(bram)) {
+            /* create a dual port ram per read port, the writes are broadcast to all of them */
+            create_nr_replicated_dual_port_rams(bram, netlist);
+
         } else {
             /* create a dual port ram and muxed all read together and all writes together */
             create_nrmw_dual_port_ram(bram, netlist);
@@ -1353,6 +2163,9 @@ void resolve_ymem2_node(nnode_t *node, uintptr_t traverse_mark_number, netlist_t
  */
 void iterate_block_memories(netlist_t *netlist)
 {
+    /* small memories sharing block rams are mapped first */
+    pack_block_memories(netlist);
+
     t_linked_vptr *ptr = block_memories_info.block_memory_list;
     while (ptr != NULL) {
         block_memory_t *bram = (block_memory_t *)ptr->data_vptr;
@@ -1360,7 +2173,9 @@ void iterate_block_memories(netlist_t *netlist)
         /* validation */
         oassert(bram != NULL);
 
-        map_bram_to_mem_hardblocks(bram, netlist);
+        /* packed memories are already mapped */
+        if (bram->node != NULL)
+            map_bram_to_mem_hardblocks(bram, netlist);
         ptr = ptr->next;
     }
 
@@ -1371,9 +2186,31 @@ void iterate_block_memories(netlist_t *netlist)
         /* validation */
         oassert(rom != NULL);
 
-        map_rom_to_mem_hardblocks(rom, netlist);
+        if (rom->node != NULL)
+            map_rom_to_mem_hardblocks(rom, netlist);
         ptr = ptr->next;
     }
+
+    if (packed_memories) {
+        printf("\nMemory packing: %ld memories packed into %ld block rams\n", packed_memories, packed_brams);
+        packed_memories = packed_brams = 0;
+    }
+
+    if (lutram_memories) {
+        printf("\nLUTRAM: %ld memories mapped onto %ld %s tiles", lutram_memories, lutram_tiles, LUTRAM_string);
+        if (lutram_reclaimed_brams)
+            printf(", %ld block rams reclaimed", lutram_reclaimed_brams);
+        if (lutram_reclaimed_ffs)
+            printf(", %ld soft ram flip-flops reclaimed", lutram_reclaimed_ffs);
+        printf("\n");
+
+        lutram_memories = lutram_tiles = lutram_reclaimed_brams = lutram_reclaimed_ffs = 0;
+    }
+
+    if (replicated_memories) {
+        printf("\nRead port replication: %ld memories mapped onto %ld %s banks\n", replicated_memories, replicated_banks, DUAL_PORT_RAM_string);
+        replicated_memories = replicated_banks = 0;
+    }
 }
 
 /**
@@ -25,7 +25,7 @@
 #include <stdint.h> // INT_MAX
 #include <vector>
 
-#include "multipliers.h" // instantiate_simple_soft_multiplier
+#include "multipliers.h" // instantiate_soft_multiplier
 #include "odin_error.h"  // error_message
 
 HardSoftLogicMixer::HardSoftLogicMixer()
@@ -51,7 +51,7 @@ bool HardSoftLogicMixer::hardenable(nnode_t *node) { return this->_opts[node->ty
 
 bool HardSoftLogicMixer::enabled(nnode_t *node) { return this->_opts[node->type]->enabled(); }
 
-int HardSoftLogicMixer::hard_blocks_needed(operation_list opt) { return _nodes_by_opt[opt].size(); }
+int HardSoftLogicMixer::hard_blocks_needed(operation_list opt) { return _opts[opt]->blocks_needed(_nodes_by_opt[opt]); }
 
 void HardSoftLogicMixer::partial_map_node(nnode_t *node, short traverse_number, netlist_t *netlist)
 {
@@ -23,14 +23,20 @@
 
 #include "MixingOptimization.hpp"
 
+#include <algorithm>
+#include <queue>
 #include <stdint.h> // INT_MAX
+#include <unordered_map>
 #include <vector>
 
 #include "HardSoftLogicMixer.hpp" // HardSoftLogicMixer
 #include "adders.h"               // hard_adders
-#include "multipliers.h"          // instantiate_simple_soft_multiplier
+#include "multipliers.h"          // instantiate_soft_multiplier
 #include "netlist_statistic.h"    // mixing_optimization_stats
 #include "odin_error.h"           // error_message
+#include "parmys_capacity.hpp"     // hard_block_capacity
+
+#include "kernel/yosys.h" // Yosys::log
 
 void MixingOpt::scale_counts()
 {
@@ -89,51 +95,143 @@ void MultsOpt::assign_weights(netlist_t *netlist, std::vector<nnode_t *> nodes)
     }
 }
 
+/**
+ * The pieces iterate_multipliers split a multiplier into share its
+ * split_group and are allocated together: a multiplier only saves its soft
+ * logic once all its pieces are on hard blocks. Nodes the split never saw
+ * form a group of their own.
+ */
+static std::vector<std::vector<size_t>> split_groups(std::vector<nnode_t *> &nodes, MultsOpt *opt)
+{
+    std::vector<std::vector<size_t>> groups;
+    std::unordered_map<long, size_t> group_index;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!opt->hardenable(nodes[i]))
+            continue;
+
+        long group = (nodes[i]->split_group >= 0) ? nodes[i]->split_group : nodes[i]->unique_id;
+        auto found = group_index.find(group);
+        if (found == group_index.end()) {
+            group_index[group] = groups.size();
+            groups.push_back({i});
+        } else {
+            groups[found->second].push_back(i);
+        }
+    }
+    return groups;
+}
+
+/* the hard multipliers the multiplier node was split from takes */
+static int split_group_fragments(nnode_t *node)
+{
+    return (node->split_group >= 0) ? node->split_fragments : hard_multiplier_fragments(node);
+}
+
+int MultsOpt::blocks_needed(std::vector<nnode_t *> &nodes)
+{
+    int count = 0;
+    for (std::vector<size_t> &group : split_groups(nodes, this))
+        count += split_group_fragments(nodes[group[0]]);
+    return count;
+}
+
+/**
+ * The budgeted assignment is a knapsack: each hardenable multiplier costs
+ * the hard multipliers it is split into, recorded before the split, and is
+ * worth the soft logic of its pieces, scaled up to twice for the most
+ * critical ones (the depth below the node plus the depth of its soft
+ * version). Candidates are taken by decreasing value per hard block from a
+ * priority queue while they fit, and the result is compared against the
+ * best single candidate, which keeps it within a factor two of the optimum
+ * in O(n log n).
+ */
 void MultsOpt::perform(netlist_t *netlist, std::vector<nnode_t *> &weighted_nodes)
 {
-    size_t nodes_count = weighted_nodes.size();
-
-    // per optimization, instantiate hard logic
-    for (int i = 0; i < this->_blocks_count; i++) {
-        int maximal_cost = -1;
-        int index = -1;
-        for (size_t j = 0; j < nodes_count; j++) {
-            // if found a new maximal cost that is higher than a current maximum AND is not restricted by input
-            // params for minimal "hardenable" multiplier width
-            if (maximal_cost < weighted_nodes[j]->weight && this->hardenable(weighted_nodes[j])) {
-                maximal_cost = weighted_nodes[j]->weight;
-                index = j;
-            }
+    std::vector<std::vector<size_t>> groups = split_groups(weighted_nodes, this);
+    std::vector<int> fragments(groups.size(), 0);
+    std::vector<double> values(groups.size(), 0.0);
+    std::vector<long> criticality(groups.size(), 0);
+    std::vector<long> luts(groups.size(), 0);
+
+    long max_criticality = 1;
+    for (size_t g = 0; g < groups.size(); g++) {
+        fragments[g] = split_group_fragments(weighted_nodes[groups[g][0]]);
+        for (size_t i : groups[g]) {
+            long node_luts, depth;
+            estimate_soft_multiplier_cost(weighted_nodes[i], &node_luts, &depth);
+            luts[g] += node_luts;
+            criticality[g] = std::max(criticality[g], std::max<long>(weighted_nodes[i]->weight, 0) + depth);
         }
+        max_criticality = std::max(max_criticality, criticality[g]);
+    }
+
+    // value per hard block, the highest first and the earliest group on ties
+    auto lower_density = [&](size_t a, size_t b) {
+        double density_a = values[a] / fragments[a];
+        double density_b = values[b] / fragments[b];
+        return (density_a != density_b) ? density_a < density_b : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(lower_density)> queue(lower_density);
 
-        // if there are no suitable nodes left, leave the loop to
-        // implement remaining nodes in soft logic
-        if (index < 0)
-            break;
+    long best_single = -1;
+    for (size_t g = 0; g < groups.size(); g++) {
+        if (fragments[g] <= 0 || fragments[g] > this->_blocks_count)
+            continue;
 
-        // indicate for future iterations the node was hardened
-        weighted_nodes[index]->weight = -1;
+        values[g] = luts[g] * (1.0 + (double)criticality[g] / max_criticality);
+        queue.push(g);
 
-        if (hard_multipliers) {
-            instantiate_hard_multiplier(weighted_nodes[index], this->cached_traverse_value, netlist);
+        if (best_single < 0 || values[g] > values[best_single])
+            best_single = g;
+    }
+
+    std::vector<size_t> hardened;
+    long remaining = this->_blocks_count;
+    double hardened_value = 0.0;
+    while (!queue.empty() && remaining > 0) {
+        size_t g = queue.top();
+        queue.pop();
+
+        if (fragments[g] <= remaining) {
+            hardened.push_back(g);
+            hardened_value += values[g];
+            remaining -= fragments[g];
         }
     }
 
-    // From the end of the vector, remove all nodes that were implemented in hard logic. The remaining
-    // nodes will be instantiated in soft_map_remaining_nodes
-    for (int i = nodes_count - 1; i >= 0; i--) {
-        if (weighted_nodes[i]->weight == -1) {
-            weighted_nodes.erase(weighted_nodes.begin() + i);
+    if (best_single >= 0 && values[best_single] > hardened_value) {
+        hardened.assign(1, best_single);
+        remaining = this->_blocks_count - fragments[best_single];
+    }
+
+    long luts_saved = 0;
+    for (size_t g : hardened) {
+        luts_saved += luts[g];
+        for (size_t i : groups[g]) {
+            // indicate the node was hardened
+            weighted_nodes[i]->weight = -1;
+
+            if (hard_multipliers) {
+                instantiate_hard_multiplier(weighted_nodes[i], this->cached_traverse_value, netlist);
+            }
         }
     }
+
+    Yosys::log("Mixing multipliers: %zu of %zu on hard blocks, %ld of %d hard blocks used, ~%ld LUTs saved\n", hardened.size(), groups.size(),
+               (long)this->_blocks_count - remaining, this->_blocks_count, luts_saved);
+
+    // Remove all nodes that were implemented in hard logic. The remaining
+    // nodes will be instantiated in soft_map_remaining_nodes
+    weighted_nodes.erase(std::remove_if(weighted_nodes.begin(), weighted_nodes.end(), [](nnode_t *node) { return node->weight == -1; }),
+                         weighted_nodes.end());
 }
 
 void MixingOpt::set_blocks_needed(int new_count) { this->_blocks_count = new_count; }
 
 void MultsOpt::set_blocks_needed(int new_count)
 {
-    // with development for fixed_layout, this value will change
-    int availableHardBlocks = INT_MAX;
+    // the device bounds the hard multipliers when its layout is known
+    int availableHardBlocks = (hard_block_capacity.multipliers >= 0) ? (int)std::min<long>(hard_block_capacity.multipliers, INT_MAX) : INT_MAX;
     int hardBlocksNeeded = new_count;
     int hardBlocksCount = availableHardBlocks;
 
@@ -168,7 +266,7 @@ void MultsOpt::partial_map_node(nnode_t *node, short traverse_value, netlist_t *
     } else if (mixer->hardenable(node)) {
         instantiate_hard_multiplier(node, traverse_value, netlist);
     } else if (!hard_adders) {
-        instantiate_simple_soft_multiplier(node, traverse_value, netlist);
+        instantiate_soft_multiplier(node, traverse_value, netlist);
     }
     this->cached_traverse_value = traverse_value;
 }
@@ -177,7 +275,7 @@ void MultsOpt::instantiate_soft_logic(netlist_t *netlist, std::vector<nnode_t *>
 {
     unsigned int size = nodes.size();
     for (unsigned int j = 0; j < size; j++) {
-        instantiate_simple_soft_multiplier(nodes[j], this->cached_traverse_value, netlist);
+        instantiate_soft_multiplier(nodes[j], this->cached_traverse_value, netlist);
     }
     for (int i = size - 1; i >= 0; i--) {
         nodes[i] = free_nnode(nodes[i]);
@@ -101,6 +101,14 @@ class MixingOpt
      */
     virtual void set_blocks_needed(int count);
 
+    /**
+     * @brief the number of hard blocks the candidate nodes
+     * would take, one per node unless the kind knows better
+     *
+     * @param nodes the candidate nodes
+     */
+    virtual int blocks_needed(std::vector<nnode_t *> &nodes) { return nodes.size(); }
+
     operation_list get_kind() { return _kind; }
 
     /**
@@ -210,6 +218,14 @@ class MultsOpt : public MixingOpt
      */
     virtual void set_blocks_needed(int);
 
+    /**
+     * @brief the number of hard multipliers the candidates
+     * take once split to the size of the hard block
+     *
+     * @param nodes the candidate multipliers
+     */
+    virtual int blocks_needed(std::vector<nnode_t *> &nodes);
+
     /**
      * @brief based on criteria for hardening given kind of operation, return
      * if the node should be implemented in hard blocks
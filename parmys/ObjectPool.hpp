@@ -0,0 +1,156 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @file This file provides a slab based object pool used to hand
+ * out the netlist structures (nodes, pins and nets). Objects are
+ * carved out of large slabs and recycled through a free list, so
+ * building a netlist costs one malloc per slab instead of one per
+ * object and tearing it down is a bulk release of the slabs.
+ */
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <map>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+#include "odin_types.h"
+#include "vtr_memory.h"
+
+template <typename T> class ObjectPool
+{
+  private:
+    struct slot_t {
+        /* storage must stay the first member, see deallocate() */
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        slot_t *next_free;
+        bool live;
+    };
+
+    std::vector<slot_t *> slabs;
+    /* slabs by start address, to tell the objects of the pool from heap ones */
+    std::map<uintptr_t, slot_t *> slab_starts;
+    size_t slab_size;
+    size_t used_in_last_slab;
+    slot_t *free_list;
+    long num_live;
+
+  public:
+    explicit ObjectPool(size_t objects_per_slab = 4096)
+        : slab_size(objects_per_slab)
+        , used_in_last_slab(objects_per_slab)
+        , free_list(NULL)
+        , num_live(0)
+    {
+    }
+
+    ~ObjectPool() { release(); }
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    // Returns a value-initialized (zero filled) object, recycling a freed slot when possible.
+    T *allocate()
+    {
+        slot_t *slot = free_list;
+        if (slot) {
+            free_list = slot->next_free;
+        } else {
+            if (used_in_last_slab == slab_size) {
+                slabs.push_back((slot_t *)vtr::malloc(sizeof(slot_t) * slab_size));
+                slab_starts[(uintptr_t)slabs.back()] = slabs.back();
+                used_in_last_slab = 0;
+            }
+            slot = &slabs.back()[used_in_last_slab++];
+        }
+
+        slot->next_free = NULL;
+        slot->live = true;
+        num_live++;
+
+        return new (&slot->storage) T();
+    }
+
+    // Whether obj was handed out by this pool, in O(log slabs).
+    bool owns(const T *obj) const
+    {
+        uintptr_t address = (uintptr_t)obj;
+        auto slab = slab_starts.upper_bound(address);
+        if (slab == slab_starts.begin())
+            return false;
+
+        --slab;
+        return address < slab->first + sizeof(slot_t) * slab_size;
+    }
+
+    // Destroys the object and hands its slot back to the free list.
+    void deallocate(T *obj)
+    {
+        if (!obj)
+            return;
+
+        obj->~T();
+
+        slot_t *slot = reinterpret_cast<slot_t *>(obj);
+        slot->live = false;
+        slot->next_free = free_list;
+        free_list = slot;
+        num_live--;
+    }
+
+    // Destroys every object still alive and returns all slabs at once.
+    void release()
+    {
+        for (size_t i = 0; i < slabs.size(); i++) {
+            size_t used = (i + 1 == slabs.size()) ? used_in_last_slab : slab_size;
+            for (size_t j = 0; j < used; j++) {
+                if (slabs[i][j].live)
+                    reinterpret_cast<T *>(&slabs[i][j].storage)->~T();
+            }
+            vtr::free(slabs[i]);
+        }
+
+        slabs.clear();
+        slab_starts.clear();
+        used_in_last_slab = slab_size;
+        free_list = NULL;
+        num_live = 0;
+    }
+
+    long size() const { return num_live; }
+};
+
+/**
+ * The per-netlist arena: one pool per netlist structure type.
+ * It is owned by the netlist_t that created it and released in
+ * free_netlist, or by netlist_arena_guard when a run exits before.
+ */
+struct netlist_arena_t {
+    ObjectPool<nnode_t> nodes;
+    ObjectPool<npin_t> pins;
+    ObjectPool<nnet_t> nets;
+};
+
+#endif
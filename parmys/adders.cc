@@ -29,7 +29,11 @@
 #include "odin_types.h"
 #include "odin_util.h"
 #include "subtractions.h"
+#include <algorithm>
 #include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "vtr_memory.h"
 #include "vtr_util.h"
@@ -234,11 +238,13 @@ void add_the_blackbox_for_adds_yosys(Yosys::Design *design)
 
         Yosys::hashlib::dict<Yosys::RTLIL::IdString, std::pair<int, bool>> wideports_cache;
 
+        if (blackbox_defined(design, Yosys::RTLIL::escape_id("adder"))) {
+            adds = adds->next;
+            continue;
+        }
+
         module = new Yosys::RTLIL::Module;
         module->name = Yosys::RTLIL::escape_id("adder");
-
-        if (design->module(module->name))
-            Yosys::log_error("Duplicate definition of module %s!\n", Yosys::log_id(module->name));
         design->add(module);
 
         /* add the inputs */
@@ -308,60 +314,23 @@ void define_add_function_yosys(nnode_t *node, Yosys::Module *module, Yosys::Desi
     Yosys::IdString celltype = Yosys::RTLIL::escape_id(cell_type_name);
     Yosys::RTLIL::Cell *cell = module->addCell(NEW_ID, celltype);
 
-    Yosys::hashlib::dict<Yosys::RTLIL::IdString, Yosys::hashlib::dict<int, Yosys::SigBit>> cell_wideports_cache;
-
-    /* Write the input pins*/
-    for (int i = 0; i < node->num_input_pins; i++) {
-        std::string p, q;
+    for (int i = 0; i < node->num_input_pins; i++)
         oassert(node->input_pins[i]->net->num_driver_pins == 1);
-        npin_t *driver_pin = node->input_pins[i]->net->driver_pins[0];
 
-        if (i < node->input_port_sizes[0]) {
-            p = Yosys::stringf("%s[%d]", hard_adders->inputs->next->next->name, i);
-            if (!driver_pin->name)
-                q = driver_pin->node->name;
-            else
-                q = driver_pin->name;
-        } else if (i >= node->input_port_sizes[0] && i < node->input_port_sizes[1] + node->input_port_sizes[0]) {
-            p = Yosys::stringf("%s[%d]", hard_adders->inputs->next->name, i - node->input_port_sizes[0]);
-            if (!driver_pin->name)
-                q = driver_pin->node->name;
-            else
-                q = driver_pin->name;
-        } else {
-            p = Yosys::stringf("%s[%d]", hard_adders->inputs->name, i - (node->input_port_sizes[0] + node->input_port_sizes[1]));
-            if (!driver_pin->name)
-                q = driver_pin->node->name;
-            else
-                q = driver_pin->name;
-        }
+    long size_a = node->input_port_sizes[0];
+    long size_b = node->input_port_sizes[1];
 
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(p);
-        if (wp.first.empty())
-            cell->setPort(Yosys::RTLIL::escape_id(p), to_wire(q, module));
-        else
-            cell_wideports_cache[wp.first][wp.second] = to_wire(q, module);
-    }
-
-    /* Write the output pins*/
-    for (int i = 0; i < node->num_output_pins; i++) {
-        std::string p, q;
-        if (i < node->output_port_sizes[0]) {
-            p = Yosys::stringf("%s[%d]", hard_adders->outputs->next->name, i);
-            q = node->output_pins[i]->name;
-        } else {
-            p = Yosys::stringf("%s[%d]", hard_adders->outputs->name, i - node->output_port_sizes[0]);
-            q = node->output_pins[i]->name;
-        }
-
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(p);
-        if (wp.first.empty())
-            cell->setPort(Yosys::RTLIL::escape_id(p), to_wire(q, module));
-        else
-            cell_wideports_cache[wp.first][wp.second] = to_wire(q, module);
-    }
+    /* Write the input ports */
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_adders->inputs->next->next->name), input_port_sig(module, node, 0, size_a));
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_adders->inputs->next->name), input_port_sig(module, node, size_a, size_b));
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_adders->inputs->name),
+                  input_port_sig(module, node, size_a + size_b, node->num_input_pins - (size_a + size_b)));
 
-    handle_cell_wideports_cache(&cell_wideports_cache, design, module, cell);
+    /* Write the output ports */
+    long size_out = node->output_port_sizes[0];
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_adders->outputs->next->name), output_port_sig(module, node, 0, size_out));
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_adders->outputs->name),
+                  output_port_sig(module, node, size_out, node->num_output_pins - size_out));
 
     return;
 }
@@ -453,6 +422,7 @@ void init_split_adder(nnode_t *node, nnode_t *ptr, int a, int sizea, int b, int
     /* Set the number of pins and re-locate previous pin entries */
     ptr->num_input_pins = current_sizea + current_sizeb + cin;
     ptr->input_pins = (npin_t **)vtr::malloc(sizeof(void *) * (current_sizea + current_sizeb + cin));
+    ptr->input_pins_capacity = ptr->num_input_pins;
     // if flaga or flagb = 1, the input pins should be empty.
     if (flaga == 1) {
         for (i = 0; i < current_sizea; i++)
@@ -597,6 +567,7 @@ void init_split_adder(nnode_t *node, nnode_t *ptr, int a, int sizea, int b, int
 
     ptr->num_output_pins = output;
     ptr->output_pins = (npin_t **)vtr::malloc(sizeof(void *) * output);
+    ptr->output_pins_capacity = output;
     for (i = 0; i < output; i++)
         ptr->output_pins[i] = NULL;
 
@@ -909,152 +880,89 @@ void reduce_operations(netlist_t * /*netlist*/, operation_list op)
 }
 
 /*-------------------------------------------------------------------------
- * (function: traverse_list)
+ * (function: operation_signature)
  *
- * traverse the operation lists
+ * builds the structural hash key of an operation node from its type, the
+ * signedness of its operands, the width of every port and, port by port in
+ * order, the nets driving its inputs. Two nodes with the same key compute
+ * the same function of the same signals. The two operands of ADD/MULTIPLY
+ * are put in a canonical order when they have the same width and
+ * signedness, so a + b and b + a share a key; MINUS keeps its order.
+ * Nodes with an unconnected pin get no key and are never merged.
  *-----------------------------------------------------------------------*/
-void traverse_list(operation_list oper, t_linked_vptr *place)
+static bool operation_signature(nnode_t *node, operation_list oper, std::string &signature)
 {
-    while (place != NULL && place->next != NULL) {
-        match_node(place, oper);
-        place = place->next;
-    }
-}
+    if (node->type != oper)
+        return false;
 
-/*---------------------------------------------------------------------------
- * (function: match_node)
- *-------------------------------------------------------------------------*/
-void match_node(t_linked_vptr *place, operation_list oper)
-{
-    int flag = 0;
-    int mark = 0;
-    nnode_t *node = NULL;
-    nnode_t *next_node = NULL;
-    node = (nnode_t *)place->data_vptr;
-    t_linked_vptr *pre = place;
-    t_linked_vptr *next = NULL;
-    if (place->next != NULL)
-        next = place->next;
-    while (next != NULL) {
-        flag = 0;
-        mark = 0;
-        next_node = (nnode_t *)next->data_vptr;
-        if (node->type == next_node->type) {
-            if (node->num_input_pins == next_node->num_input_pins) {
-                flag = match_ports(node, next_node, oper);
-                if (flag == 1) {
-                    mark = match_pins(node, next_node);
-                    if (mark == 1) {
-                        merge_nodes(node, next_node);
-                        remove_list_node(pre, next);
-                    }
-                }
-            }
-        }
-        if (mark == 1)
-            next = pre->next;
-        else {
-            pre = next;
-            next = next->next;
-        }
+    for (int i = 0; i < node->num_output_pins; i++) {
+        if (!node->output_pins[i] || !node->output_pins[i]->net)
+            return false;
     }
-}
-
-/*---------------------------------------------------------------------------
- * (function: match_ports)
- *-------------------------------------------------------------------------*/
-int match_ports(nnode_t *node, nnode_t *next_node, operation_list oper)
-{
-    int flag = 0;
-    int sign = 0;
-    int mark1 = 1;
-    int mark2 = 1;
-    ast_node_t *ast_node, *ast_node_next;
-    char *component_s[2] = {0};
-    char *component_o[2] = {0};
-    ast_node = node->related_ast_node;
-    ast_node_next = next_node->related_ast_node;
-    /* in case of coarsen blifs, there is no related ast node, so we skip this part */
-    if (ast_node && ast_node->types.operation.op == oper) {
-        traverse_operation_node(ast_node, component_s, oper, &sign);
-        if (sign != 1) {
-            traverse_operation_node(ast_node_next, component_o, oper, &sign);
-            if (sign != 1) {
-                oassert(component_s[0] && component_o[0] && "missing children on operation");
-                switch (oper) {
-                case ADD:
-                case MULTIPLY: {
-                    mark1 = strcmp(component_s[0], component_o[0]);
-                    if (component_s[1] && component_o[1]) {
-                        if (mark1 == 0) {
-                            mark2 = strcmp(component_s[1], component_o[1]);
-                        } else {
-                            mark1 = strcmp(component_s[0], component_o[1]);
-                            mark2 = strcmp(component_s[1], component_o[0]);
-                        }
-                    }
-                } break;
-
-                case MINUS: {
-                    mark1 = strcmp(component_s[0], component_o[0]);
-                    if (mark1 == 0 && component_s[1] && component_o[1]) {
-                        mark2 = strcmp(component_s[1], component_o[1]);
-                    }
-                } break;
-
-                default:
 
-                    break;
-                }
-                if (mark1 == 0 && mark2 == 0) {
-                    flag = 1;
-                }
-            }
-        }
-        for (int i = 0; i < ast_node->num_children; i++) {
-            if (ast_node->children[i]->type != IDENTIFIERS) {
-                vtr::free(component_s[i]);
-            }
-        }
-        for (int i = 0; i < ast_node_next->num_children; i++) {
-            if (ast_node_next->children[i]->type != IDENTIFIERS) {
-                vtr::free(component_o[i]);
-            }
+    std::vector<std::string> ports(node->num_input_port_sizes);
+    int pin = 0;
+    for (int port = 0; port < node->num_input_port_sizes; port++) {
+        ports[port] = std::to_string(node->input_port_sizes[port]) + ":";
+        for (int i = 0; i < node->input_port_sizes[port]; i++, pin++) {
+            if (pin >= node->num_input_pins || !node->input_pins[pin] || !node->input_pins[pin]->net)
+                return false;
+            ports[port] += std::to_string(node->input_pins[pin]->net->unique_id) + ",";
         }
     }
-
-    return flag;
+    if (pin != node->num_input_pins)
+        return false;
+
+    operation_list signed_a = node->attributes->port_a_signed;
+    operation_list signed_b = node->attributes->port_b_signed;
+    if (oper != MINUS && ports.size() == 2 && signed_a == signed_b && node->input_port_sizes[0] == node->input_port_sizes[1] && ports[1] < ports[0])
+        std::swap(ports[0], ports[1]);
+
+    signature = std::to_string(node->type) + "|" + std::to_string(signed_a) + "|" + std::to_string(signed_b);
+    for (const std::string &port : ports)
+        signature += "|" + port;
+    signature += "|";
+    for (int port = 0; port < node->num_output_port_sizes; port++)
+        signature += std::to_string(node->output_port_sizes[port]) + ",";
+
+    return true;
 }
 
 /*-------------------------------------------------------------------------
- * (function: traverse_operation_node)
+ * (function: traverse_list)
  *
- * search the ast find the couple of components
+ * traverse the operation lists and merge the redundant nodes in a single
+ * pass: every node is hashed by its operation_signature and merged into
+ * the first earlier node with the same signature.
  *-----------------------------------------------------------------------*/
-void traverse_operation_node(ast_node_t *node, char *component[], operation_list op, int *mark)
+void traverse_list(operation_list oper, t_linked_vptr *place)
 {
-    long i;
-
-    if (node == NULL)
-        return;
-
-    if (node->types.operation.op == op) {
-        for (i = 0; i < node->num_children; i++) {
-            *mark = 0;
-            if (node->children[i]->type != IDENTIFIERS && node->children[i]->type != NUMBERS) {
-                *mark = 1;
-                break;
+    std::unordered_map<std::string, nnode_t *> representatives;
+    std::string signature;
+
+    t_linked_vptr *pre = NULL;
+    while (place != NULL) {
+        nnode_t *node = (nnode_t *)place->data_vptr;
+        bool merged = false;
+
+        if (operation_signature(node, oper, signature)) {
+            auto found = representatives.find(signature);
+            if (found != representatives.end()) {
+                merge_nodes(found->second, node);
+                merged = true;
             } else {
-                if (node->children[i]->type == IDENTIFIERS) {
-                    component[i] = node->children[i]->types.identifier;
-                } else if (node->children[i]->type == NUMBERS) {
-                    long value = node->children[i]->types.vnumber->get_value();
-                    long len = snprintf(NULL, 0, "%ld", value);
-                    component[i] = (char *)vtr::calloc(len + 1, sizeof(char));
-                    odin_sprintf(component[i], "%ld", value);
-                }
+                representatives[signature] = node;
             }
         }
+
+        if (merged) {
+            /* the list head is never merged since it has no earlier candidate */
+            remove_list_node(pre, place);
+            place = pre->next;
+        } else {
+            pre = place;
+            place = place->next;
+        }
     }
 }
 
@@ -1085,19 +993,8 @@ void remove_list_node(t_linked_vptr *pre, t_linked_vptr *next)
  *-------------------------------------------------------------------------*/
 void remove_fanout_pins(nnode_t *node)
 {
-    int i, j, k, idx;
-    for (i = 0; i < node->num_input_pins; i++) {
-        idx = node->input_pins[i]->unique_id;
-        for (j = 0; j < node->input_pins[i]->net->num_fanout_pins; j++) {
-            if (node->input_pins[i]->net->fanout_pins[j]->unique_id == idx)
-                break;
-        }
-        for (k = j; k < node->input_pins[i]->net->num_fanout_pins - 1; k++) {
-            node->input_pins[i]->net->fanout_pins[k] = node->input_pins[i]->net->fanout_pins[k + 1];
-            node->input_pins[i]->net->fanout_pins[k]->pin_net_idx = k;
-        }
-        node->input_pins[i]->net->fanout_pins[k] = NULL;
-        node->input_pins[i]->net->num_fanout_pins--;
+    for (int i = 0; i < node->num_input_pins; i++) {
+        remove_fanout_pin_unordered(node->input_pins[i]->net, node->input_pins[i]);
     }
 }
 
@@ -1139,31 +1036,6 @@ void free_op_nodes(nnode_t *node)
     free_nnode(node);
 }
 
-/*---------------------------------------------------------------------------
- * (function: match_pins)
- *-------------------------------------------------------------------------*/
-int match_pins(nnode_t *node, nnode_t *next_node)
-{
-    for (int i = 0; i < node->num_input_pins; i++) {
-        for (int j = 0; j < node->input_pins[i]->net->num_driver_pins; j++) {
-            bool found = false;
-            long id = node->input_pins[i]->net->driver_pins[j]->unique_id;
-            for (int k = 0; k < next_node->num_input_pins && !found; k++) {
-                for (int l = 0; l < next_node->input_pins[k]->net->num_driver_pins; l++) {
-                    if (id == next_node->input_pins[k]->net->driver_pins[l]->unique_id) {
-                        found = true;
-                        break;
-                    }
-                }
-            }
-            if (!found)
-                return -1;
-        }
-    }
-
-    return 1;
-}
-
 /*---------------------------------------------------------------------------------------------
  * connect adder type output pin to a node
  *-------------------------------------------------------------------------------------------*/
@@ -1226,10 +1098,10 @@ static nnode_t *make_adder(operation_list funct, nnode_t *current_adder, nnode_t
             oassert(temp_pin->net->num_driver_pins <= 1);
             if (!temp_pin->net->num_driver_pins || temp_pin->net->driver_pins[0]->node->type == GND_NODE) {
                 connect_nodes(netlist->gnd_node, 0, new_funct, 0 + is_three_port_gate);
-                remove_fanout_pins_from_net(temp_pin->net, temp_pin, temp_pin->pin_net_idx);
+                remove_fanout_pin_unordered(temp_pin->net, temp_pin);
             } else if (temp_pin->net->driver_pins[0]->node->type == VCC_NODE) {
                 connect_nodes(netlist->vcc_node, 0, new_funct, 0 + is_three_port_gate);
-                remove_fanout_pins_from_net(temp_pin->net, temp_pin, temp_pin->pin_net_idx);
+                remove_fanout_pin_unordered(temp_pin->net, temp_pin);
             } else {
                 remap_pin_to_new_node(temp_pin, new_funct, 0 + is_three_port_gate);
             }
@@ -1245,11 +1117,11 @@ static nnode_t *make_adder(operation_list funct, nnode_t *current_adder, nnode_t
             if (temp_pin->net->num_driver_pins == 0 || temp_pin->net->driver_pins[0]->node->type == GND_NODE) {
                 nnode_t *attach_to = (subtraction) ? netlist->vcc_node : netlist->gnd_node;
                 connect_nodes(attach_to, 0, new_funct, 1 + is_three_port_gate);
-                remove_fanout_pins_from_net(temp_pin->net, temp_pin, temp_pin->pin_net_idx);
+                remove_fanout_pin_unordered(temp_pin->net, temp_pin);
             } else if (temp_pin->net->driver_pins[0]->node->type == VCC_NODE) {
                 nnode_t *attach_to = (subtraction) ? netlist->gnd_node : netlist->vcc_node;
                 connect_nodes(attach_to, 0, new_funct, 1 + is_three_port_gate);
-                remove_fanout_pins_from_net(temp_pin->net, temp_pin, temp_pin->pin_net_idx);
+                remove_fanout_pin_unordered(temp_pin->net, temp_pin);
             } else {
                 if (subtraction) {
                     nnode_t *new_not_cells = make_not_gate(node, mark);
@@ -56,15 +56,11 @@ void iterate_adders(netlist_t *netlist);
 void clean_adders();
 void reduce_operations(netlist_t *netlist, operation_list op);
 void traverse_list(operation_list oper, vtr::t_linked_vptr *place);
-void match_node(vtr::t_linked_vptr *place, operation_list oper);
-int match_ports(nnode_t *node, nnode_t *next_node, operation_list oper);
-void traverse_operation_node(ast_node_t *node, char *component[], operation_list op, int *mark);
 void merge_nodes(nnode_t *node, nnode_t *next_node);
 void remove_list_node(vtr::t_linked_vptr *node, vtr::t_linked_vptr *place);
 void remove_fanout_pins(nnode_t *node);
 void reallocate_pins(nnode_t *node, nnode_t *next_node);
 void free_op_nodes(nnode_t *node);
-int match_pins(nnode_t *node, nnode_t *next_node);
 
 void instantiate_add_w_carry_block(int *width, nnode_t *node, short mark, netlist_t *netlist, short subtraction);
 nnode_t *check_missing_ports(nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist);
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Scalability benchmarks for the parmys pass.
+#
+# Generates parameterized stress designs (multiplier arrays, adder trees,
+# dual-port RAM banks, barrel shifters and wide muxes) at several sizes,
+# runs them through yosys + parmys -profile_json and collects the
+# per-phase wall/cpu time and memory of every run into one JSON file.
+#
+#   bench.py run [--sizes small,medium] [--only mult_array] -o results.json
+#   bench.py compare baseline.json results.json [--tolerance 1.25]
+#
+# --parmys-args hands extra options to parmys, e.g. comparing the soft
+# multiplier architectures on the multiplier arrays:
+#
+#   bench.py run --only mult_array --parmys-args "-exact_mults 0 -soft_mult array" -o array.json
+#   bench.py run --only mult_array --parmys-args "-exact_mults 0 -soft_mult tree" -o tree.json
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ARCH = os.path.join(HERE, "..", "tests", "raygentop", "k6_frac_N10_frac_chain_mem32K_40nm.xml")
+CONFIG = os.path.join(HERE, "odin_config.xml")
+SCRIPT = os.path.join(HERE, "bench.tcl")
+
+
+def mult_array(count, a_width, b_width):
+    return f"""
+module {{name}} (input clk, input [{count * a_width - 1}:0] a, input [{count * b_width - 1}:0] b,
+                 output reg [{count * (a_width + b_width) - 1}:0] p);
+    integer i;
+    always @(posedge clk)
+        for (i = 0; i < {count}; i = i + 1)
+            p[i * {a_width + b_width} +: {a_width + b_width}] <= a[i * {a_width} +: {a_width}] * b[i * {b_width} +: {b_width}];
+endmodule
+"""
+
+
+def adder_tree(count, width):
+    out_width = width + count.bit_length()
+    terms = " + ".join(f"x[{i * width} +: {width}]" for i in range(count))
+    return f"""
+module {{name}} (input clk, input [{count * width - 1}:0] x, output reg [{out_width - 1}:0] sum);
+    always @(posedge clk)
+        sum <= {terms};
+endmodule
+"""
+
+
+def dpram_bank(banks, depth_bits, width):
+    return f"""
+module {{name}} (input clk, input [{banks - 1}:0] we, input [{depth_bits - 1}:0] waddr, input [{depth_bits - 1}:0] raddr,
+                 input [{width - 1}:0] din, output reg [{banks * width - 1}:0] dout);
+    genvar b;
+    generate
+        for (b = 0; b < {banks}; b = b + 1) begin : bank
+            reg [{width - 1}:0] mem [0:{(1 << depth_bits) - 1}];
+            always @(posedge clk) begin
+                if (we[b])
+                    mem[waddr] <= din;
+                dout[b * {width} +: {width}] <= mem[raddr];
+            end
+        end
+    endgenerate
+endmodule
+"""
+
+
+def barrel_shifter(width):
+    shift_bits = max(1, (width - 1).bit_length())
+    return f"""
+module {{name}} (input clk, input [{width - 1}:0] a, input [{shift_bits - 1}:0] s,
+                 output reg [{width - 1}:0] l, output reg [{width - 1}:0] r);
+    always @(posedge clk) begin
+        l <= a << s;
+        r <= $signed(a) >>> s;
+    end
+endmodule
+"""
+
+
+def wide_mux(inputs, width):
+    sel_bits = max(1, (inputs - 1).bit_length())
+    return f"""
+module {{name}} (input clk, input [{inputs * width - 1}:0] d, input [{sel_bits - 1}:0] sel, output reg [{width - 1}:0] q);
+    always @(posedge clk)
+        q <= d[sel * {width} +: {width}];
+endmodule
+"""
+
+
+# family -> size -> generator arguments
+DESIGNS = {
+    "mult_array": (mult_array, {"small": (4, 8, 8), "medium": (16, 16, 16), "large": (32, 32, 32)}),
+    "adder_tree": (adder_tree, {"small": (16, 16), "medium": (64, 32), "large": (256, 32)}),
+    "dpram_bank": (dpram_bank, {"small": (2, 8, 16), "medium": (8, 10, 32), "large": (32, 12, 32)}),
+    "barrel_shifter": (barrel_shifter, {"small": (32,), "medium": (128,), "large": (512,)}),
+    "wide_mux": (wide_mux, {"small": (16, 16), "medium": (64, 32), "large": (256, 64)}),
+}
+
+
+def count_cells(log_path):
+    """number of cells of the last stat in the log, None if there is none"""
+    cells = None
+    if os.path.exists(log_path):
+        with open(log_path) as f:
+            for line in f:
+                if line.strip().startswith("Number of cells:"):
+                    cells = int(line.split(":")[1])
+    return cells
+
+
+def run_design(family, size, work_dir, yosys, parmys_args):
+    generator, sizes = DESIGNS[family]
+    name = f"{family}_{size}"
+    with open(os.path.join(work_dir, name + ".v"), "w") as f:
+        f.write(generator(*sizes[size]).replace("{name}", name))
+
+    env = dict(os.environ, BENCH_DESIGN=name, BENCH_ARCH=ARCH, BENCH_CONFIG=CONFIG, BENCH_PARMYS_ARGS=parmys_args)
+    start = time.time()
+    proc = subprocess.Popen([yosys, "-q", "-l", name + ".log", "-c", SCRIPT], cwd=work_dir, env=env)
+    # wait4 gives the resource usage of this run alone, RUSAGE_CHILDREN would
+    # report the largest of all the runs so far
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.time() - start
+    returncode = os.waitstatus_to_exitcode(status)
+    proc.returncode = returncode  # already reaped, keeps Popen from waiting again
+
+    result = {
+        "design": name,
+        "family": family,
+        "size": size,
+        "params": list(sizes[size]),
+        "status": returncode,
+        "wall_s": round(wall, 3),
+        "cpu_s": round(usage.ru_utime + usage.ru_stime, 3),
+        "peak_rss_kb": usage.ru_maxrss,
+        "cells": count_cells(os.path.join(work_dir, name + ".log")),
+        "phases": [],
+    }
+
+    profile = os.path.join(work_dir, name + ".profile.json")
+    if returncode == 0 and os.path.exists(profile):
+        with open(profile) as f:
+            result["phases"] = json.load(f)["phases"]
+
+    return result
+
+
+def run(args):
+    sizes = args.sizes.split(",")
+    families = args.only.split(",") if args.only else list(DESIGNS)
+    os.makedirs(args.work_dir, exist_ok=True)
+
+    results = []
+    for size in sizes:
+        for family in families:
+            result = run_design(family, size, args.work_dir, args.yosys, args.parmys_args)
+            status = "ok" if result["status"] == 0 else f"FAILED ({result['status']})"
+            cells = result["cells"] if result["cells"] is not None else "-"
+            print(f"{result['design']:<24} {result['wall_s']:>9.2f}s {result['peak_rss_kb'] / 1024:>9.1f}MB {cells:>9} cells  {status}")
+            results.append(result)
+
+    with open(args.output, "w") as f:
+        json.dump({"results": results}, f, indent=2)
+
+    return 0 if all(r["status"] == 0 for r in results) else 1
+
+
+def compare(args):
+    if not os.path.exists(args.baseline):
+        print(f"no baseline at {args.baseline}, create it with `make bench-baseline` on the reference build")
+        return 1
+
+    with open(args.baseline) as f:
+        baseline = {r["design"]: r for r in json.load(f)["results"]}
+    with open(args.results) as f:
+        results = json.load(f)["results"]
+
+    regressions = 0
+    for result in results:
+        base = baseline.get(result["design"])
+        if base is None or base["status"] != 0 or result["status"] != 0:
+            continue
+
+        base_phases = {p["phase"]: p for p in base["phases"]}
+        checks = [("total", base["wall_s"] * 1000, result["wall_s"] * 1000), ("peak rss", base["peak_rss_kb"], result["peak_rss_kb"])]
+        checks += [(p["phase"], base_phases[p["phase"]]["wall_ms"], p["wall_ms"]) for p in result["phases"] if p["phase"] in base_phases]
+
+        for what, old, new in checks:
+            # ignore phases too short to time reliably
+            if old < args.min_ms and what != "peak rss":
+                continue
+            ratio = new / old if old > 0 else 1.0
+            if ratio > args.tolerance:
+                regressions += 1
+                print(f"{result['design']:<24} {what:<28} {old:>12.1f} -> {new:>12.1f}  x{ratio:.2f}")
+
+    print(f"{regressions} regression(s) above x{args.tolerance}")
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    run_parser = sub.add_parser("run", help="generate and run the benchmark designs")
+    run_parser.add_argument("--sizes", default="small,medium", help="comma separated list of " + ",".join(DESIGNS["mult_array"][1]))
+    run_parser.add_argument("--only", default="", help="comma separated list of " + ",".join(DESIGNS))
+    run_parser.add_argument("--work-dir", default="run", help="where the designs and logs are written")
+    run_parser.add_argument("--yosys", default="yosys")
+    run_parser.add_argument("--parmys-args", default="", help="extra options handed to parmys")
+    run_parser.add_argument("-o", "--output", default="results.json")
+
+    compare_parser = sub.add_parser("compare", help="compare a run against a baseline")
+    compare_parser.add_argument("baseline")
+    compare_parser.add_argument("results")
+    compare_parser.add_argument("--tolerance", type=float, default=1.25, help="largest accepted new/old ratio")
+    compare_parser.add_argument("--min-ms", type=float, default=50.0, help="phases faster than this in the baseline are not compared")
+
+    args = parser.parse_args()
+    return run(args) if args.command == "run" else compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,61 @@
+yosys -import
+
+plugin -i parmys
+
+yosys -import
+
+read_verilog -nomem2reg +/parmys/vtr_primitives.v
+
+setattr -mod -set keep_hierarchy 1 single_port_ram
+
+setattr -mod -set keep_hierarchy 1 dual_port_ram
+
+parmys_arch -a $::env(BENCH_ARCH)
+
+read_verilog -sv -nolatches $::env(BENCH_DESIGN).v
+
+hierarchy -check -top $::env(BENCH_DESIGN)
+
+opt_expr
+
+opt_clean
+
+check
+
+opt -nodffe -nosdff
+
+procs -norom
+
+fsm
+
+opt
+
+wreduce
+
+peepopt
+
+opt_clean
+
+share
+
+opt -full
+
+memory -nomap
+
+flatten
+
+opt -full
+
+techmap -map +/parmys/adff2dff.v
+
+techmap -map +/parmys/adffe2dff.v
+
+techmap -map +/parmys/aldff2dff.v
+
+techmap -map +/parmys/aldffe2dff.v
+
+opt -full
+
+parmys -a $::env(BENCH_ARCH) -nopass -c $::env(BENCH_CONFIG) -profile_json $::env(BENCH_DESIGN).profile.json {*}$::env(BENCH_PARMYS_ARGS)
+
+tee -o /dev/stdout stat
@@ -21,6 +21,7 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <stdlib.h>
 
 #include "hard_blocks.h"
@@ -118,8 +119,6 @@ t_model *find_hard_block(const char *name)
 
 void cell_hard_block(nnode_t *node, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design)
 {
-    int index, port;
-
     /* Assert that every hard block has at least an input and output */
     oassert(node->input_port_sizes[0] > 0);
     oassert(node->output_port_sizes[0] > 0);
@@ -127,12 +126,8 @@ void cell_hard_block(nnode_t *node, Yosys::Module *module, netlist_t *netlist, Y
     Yosys::IdString celltype = Yosys::RTLIL::escape_id(node->related_ast_node->identifier_node->types.identifier);
     Yosys::RTLIL::Cell *cell = module->addCell(NEW_ID, celltype);
 
-    Yosys::hashlib::dict<Yosys::RTLIL::IdString, Yosys::hashlib::dict<int, Yosys::SigBit>> cell_wideports_cache;
-
-    /* print the input port mappings */
-    port = index = 0;
+    /* check the input pins are driven */
     for (int i = 0; i < node->num_input_pins; i++) {
-        /* Check that the input pin is driven */
         if (node->input_pins[i]->net->num_driver_pins == 0 && node->input_pins[i]->net != netlist->zero_net &&
             node->input_pins[i]->net != netlist->one_net && node->input_pins[i]->net != netlist->pad_net) {
             warning_message(NETLIST, node->loc, "Signal %s is not driven. padding with ground\n", node->input_pins[i]->name);
@@ -141,61 +136,23 @@ void cell_hard_block(nnode_t *node, Yosys::Module *module, netlist_t *netlist, Y
             error_message(NETLIST, node->loc, "Multiple (%d) driver pins not supported in hard block definition\n",
                           node->input_pins[i]->net->num_driver_pins);
         }
-        std::string p, q;
-
-        if (node->input_port_sizes[port] == 1) {
-            p = node->input_pins[i]->mapping;
-            if (node->input_pins[i]->net->driver_pins[0]->name != NULL)
-                q = node->input_pins[i]->net->driver_pins[0]->name;
-            else
-                q = node->input_pins[i]->net->driver_pins[0]->node->name;
-        } else {
-            p = Yosys::stringf("%s[%d]", node->input_pins[i]->mapping, index);
-            if (node->input_pins[i]->net->driver_pins[0]->name != NULL)
-                q = node->input_pins[i]->net->driver_pins[0]->name;
-            else
-                q = node->input_pins[i]->net->driver_pins[0]->node->name;
-        }
-
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(p);
-        if (wp.first.empty())
-            cell->setPort(Yosys::RTLIL::escape_id(p), to_wire(q, module));
-        else
-            cell_wideports_cache[wp.first][wp.second] = to_wire(q, module);
-
-        index++;
-        if (node->input_port_sizes[port] == index) {
-            index = 0;
-            port++;
-        }
     }
 
-    /* print the output port mappings */
-    port = index = 0;
-    for (int i = 0; i < node->num_output_pins; i++) {
-        std::string p, q;
-        if (node->output_port_sizes[port] != 1) {
-            p = Yosys::stringf("%s[%d]", node->output_pins[i]->mapping, index);
-            q = node->output_pins[i]->name;
-        } else {
-            p = node->output_pins[i]->mapping;
-            q = node->output_pins[i]->name;
-        }
-
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(p);
-        if (wp.first.empty())
-            cell->setPort(Yosys::RTLIL::escape_id(p), to_wire(q, module));
-        else
-            cell_wideports_cache[wp.first][wp.second] = to_wire(q, module);
-
-        index++;
-        if (node->output_port_sizes[port] == index) {
-            index = 0;
-            port++;
-        }
+    /* connect the input ports, one port at a time */
+    long start = 0;
+    for (int port = 0; port < node->num_input_port_sizes && start < node->num_input_pins; port++) {
+        long width = std::min((long)node->input_port_sizes[port], node->num_input_pins - start);
+        set_cell_port(design, cell, Yosys::RTLIL::escape_id(node->input_pins[start]->mapping), input_port_sig(module, node, start, width));
+        start += width;
     }
 
-    handle_cell_wideports_cache(&cell_wideports_cache, design, module, cell);
+    /* connect the output ports */
+    start = 0;
+    for (int port = 0; port < node->num_output_port_sizes && start < node->num_output_pins; port++) {
+        long width = std::min((long)node->output_port_sizes[port], node->num_output_pins - start);
+        set_cell_port(design, cell, Yosys::RTLIL::escape_id(node->output_pins[start]->mapping), output_port_sig(module, node, start, width));
+        start += width;
+    }
 
     for (auto &param : node->cell_parameters) {
         cell->parameters[Yosys::RTLIL::IdString(param.first)] = Yosys::Const(param.second);
@@ -224,11 +181,13 @@ void output_hard_blocks_yosys(Yosys::Design *design)
 
             Yosys::hashlib::dict<Yosys::RTLIL::IdString, std::pair<int, bool>> wideports_cache;
 
+            if (blackbox_defined(design, Yosys::RTLIL::escape_id(hard_blocks->name))) {
+                hard_blocks = hard_blocks->next;
+                continue;
+            }
+
             module = new Yosys::RTLIL::Module;
             module->name = Yosys::RTLIL::escape_id(hard_blocks->name);
-
-            if (design->module(module->name))
-                Yosys::log_error("Duplicate definition of module %s!\n", Yosys::log_id(module->name));
             design->add(module);
 
             hb_ports = hard_blocks->inputs;
@@ -44,6 +44,10 @@ t_model *dual_port_rams = NULL;
 t_linked_vptr *sp_memory_list;
 t_linked_vptr *dp_memory_list;
 
+/* width/depth modes of the memory pb_types, empty when only the models are known */
+std::vector<ram_mode_t> sp_ram_modes;
+std::vector<ram_mode_t> dp_ram_modes;
+
 void copy_input_port_to_memory(nnode_t *node, signal_list_t *signals, const char *port_name);
 void pad_dp_memory_width(nnode_t *node, netlist_t *netlist);
 void pad_sp_memory_width(nnode_t *node, netlist_t *netlist);
@@ -54,6 +58,12 @@ int get_sp_ram_split_width();
 int get_dp_ram_split_width();
 void filter_memories_by_soft_logic_cutoff();
 
+static void collect_pb_type_memory_modes(t_pb_type *pb_type);
+static int get_memory_port_size(nnode_t *node, const char *port_name);
+static bool plan_memory_tiling(const std::vector<ram_mode_t> &modes, long addr_width, long data_width, ram_mode_t *plan);
+static long get_planned_split_depth(const std::vector<ram_mode_t> &modes, nnode_t *node, const char *addr_name, const char *data_name, long split_depth);
+static int get_planned_split_width(const std::vector<ram_mode_t> &modes, nnode_t *node, const char *addr_name, const char *data_name, int split_width);
+
 /**
  * (function: init_sp_ram_signals)
  *
@@ -306,12 +316,79 @@ void check_memories_and_report_distribution()
     return;
 }
 
+/*
+ * Creates the memory node holding the given bank of a depth split memory.
+ */
+static nnode_t *make_memory_bank(nnode_t *node, long bank)
+{
+    nnode_t *bank_node = allocate_nnode(node->loc);
+
+    bank_node->name = append_string(node->name, "__B%ld", bank);
+    bank_node->type = node->type;
+    bank_node->related_ast_node = node->related_ast_node;
+    bank_node->traverse_visited = node->traverse_visited;
+
+    return bank_node;
+}
+
+/*
+ * Adds the given write enable of a bank as a port of the bank memory.
+ */
+static void add_memory_bank_we(nnode_t *bank_node, nnet_t *we_net, const char *port_name)
+{
+    signal_list_t *we = init_signal_list();
+    add_pin_to_signal_list(we, make_fanout_pin(we_net));
+    add_input_port_to_memory(bank_node, we, port_name);
+    free_signal_list(we);
+}
+
+/*-------------------------------------------------------------------------
+ * (function: mux_memory_banks)
+ *
+ * Drives the given output port of a depth split memory from the outputs
+ *   of its banks, starting at offset, through one mux per bit selected by
+ *   the decoded bank select signals.
+ *-----------------------------------------------------------------------*/
+static void mux_memory_banks(signal_list_t *out, std::vector<nnode_t *> &banks, int offset, std::vector<nnet_t *> &bank_select, const char *port_name, nnode_t *node)
+{
+    long num_banks = banks.size();
+
+    for (int i = 0; i < out->count; i++) {
+        nnode_t *mux = make_2port_gate(MUX_2, num_banks, num_banks, 1, node, node->traverse_visited);
+
+        for (long bank = 0; bank < num_banks; bank++) {
+            add_input_pin_to_node(mux, make_fanout_pin(bank_select[bank]), bank);
+
+            connect_nodes(banks[bank], offset + i, mux, num_banks + bank);
+            npin_t *bank_pin = banks[bank]->output_pins[offset + i];
+            if (bank_pin->mapping)
+                vtr::free(bank_pin->mapping);
+            bank_pin->mapping = vtr::strdup(port_name);
+        }
+
+        npin_t *pin = out->pins[i];
+        if (pin->name)
+            vtr::free(pin->name);
+        pin->name = vtr::strdup(mux->name);
+
+        if (pin->mapping)
+            vtr::free(pin->mapping);
+        pin->mapping = NULL;
+
+        remap_pin_to_new_node(pin, mux, 0);
+    }
+}
+
 /*-------------------------------------------------------------------------
  * (function: split_sp_memory_depth)
  *
  * This function works to split the depth of a single port memory into
  *   several smaller memories.
  *
+ *   The low address bits select one of 2^(address bits - split_size)
+ *   banks, which are built in one pass along with the write enable
+ *   decoder and the output muxes.
+ *
  *   split_size: the number of address bits in the resulting memory.
  *------------------------------------------------------------------------
  */
@@ -328,117 +405,61 @@ void split_sp_memory_depth(nnode_t *node, int split_size)
         return;
     }
 
+    int select_width = logical_size - split_size;
+    long num_banks = shift_left_value_with_overflow_check(0x1, select_width, node->loc);
+
     int i;
     signal_list_t *new_addr = init_signal_list();
-    for (i = 1; i < signals->addr->count; i++)
+    for (i = select_width; i < signals->addr->count; i++)
         add_pin_to_signal_list(new_addr, signals->addr->pins[i]);
 
-    /* Create the new memory node */
-    nnode_t *new_mem_node1 = allocate_nnode(node->loc);
-    nnode_t *new_mem_node2 = allocate_nnode(node->loc);
-
-    // Append the new name with an __S or __H
-    new_mem_node1->name = append_string(node->name, "__S");
-    new_mem_node2->name = append_string(node->name, "__H");
-
-    /* Copy properties from the original memory node */
-    new_mem_node1->type = node->type;
-    new_mem_node1->related_ast_node = node->related_ast_node;
-    new_mem_node1->traverse_visited = node->traverse_visited;
-    new_mem_node2->type = node->type;
-    new_mem_node2->related_ast_node = node->related_ast_node;
-    new_mem_node2->traverse_visited = node->traverse_visited;
-
-    // Move over the original pins to the first memory node.
     signal_list_t *clk = init_signal_list();
     add_pin_to_signal_list(clk, signals->clk);
-    remap_input_port_to_memory(new_mem_node1, new_addr, "addr");
-    remap_input_port_to_memory(new_mem_node1, signals->data, "data");
-
-    // Copy the inputs to the second memory node.
-    copy_input_port_to_memory(new_mem_node2, new_addr, "addr");
-    copy_input_port_to_memory(new_mem_node2, signals->data, "data");
-
-    // Hook up addresses and write enables.
-    {
-        signal_list_t *we;
-        nnode_t *and_g = make_2port_gate(LOGICAL_AND, 1, 1, 1, new_mem_node1, new_mem_node1->traverse_visited);
-        remap_pin_to_new_node(signals->we, and_g, 1);
-        remap_pin_to_new_node(signals->addr->pins[0], and_g, 0);
-
-        we = make_output_pins_for_existing_node(and_g, 1);
-        add_input_port_to_memory(new_mem_node1, we, "we");
-        free_signal_list(we);
-
-        nnode_t *not_g = make_not_gate_with_input(copy_input_npin(signals->addr->pins[0]), new_mem_node2, new_mem_node2->traverse_visited);
-        and_g = make_2port_gate(LOGICAL_AND, 1, 1, 1, new_mem_node2, new_mem_node2->traverse_visited);
-        connect_nodes(not_g, 0, and_g, 0);
-
-        add_input_pin_to_node(and_g, copy_input_npin(signals->we), 1);
-
-        we = make_output_pins_for_existing_node(and_g, 1);
-        add_input_port_to_memory(new_mem_node2, we, "we");
-        free_signal_list(we);
-    }
-
-    // Add the clock signals.
-    remap_input_port_to_memory(new_mem_node1, clk, "clk");
-    copy_input_port_to_memory(new_mem_node2, clk, "clk");
-    free_signal_list(clk);
 
-    // Setup output ports on both nodes.
-    allocate_more_output_pins(new_mem_node1, signals->out->count);
-    add_output_port_information(new_mem_node1, signals->out->count);
+    // Decode the bank selects, the write enables take over the original pins.
+    std::vector<nnet_t *> bank_select = decode_address_banks(signals->addr, 0, select_width, NULL, false, node, NULL);
+    std::vector<nnet_t *> bank_we = decode_address_banks(signals->addr, 0, select_width, signals->we, true, node, NULL);
 
-    allocate_more_output_pins(new_mem_node2, signals->out->count);
-    add_output_port_information(new_mem_node2, signals->out->count);
+    std::vector<nnode_t *> banks(num_banks, NULL);
+    for (long bank = 0; bank < num_banks; bank++) {
+        banks[bank] = make_memory_bank(node, bank);
 
-    /* Copy over the output pins for the new memory */
-    for (i = 0; i < signals->data->count; i++) {
-        nnode_t *mux = make_2port_gate(MUX_2, 2, 2, 1, new_mem_node1, new_mem_node1->traverse_visited);
-        nnode_t *not_g = make_not_gate(new_mem_node1, new_mem_node1->traverse_visited);
-        add_input_pin_to_node(mux, copy_input_npin(signals->addr->pins[0]), 0);
-        add_input_pin_to_node(not_g, copy_input_npin(signals->addr->pins[0]), 0);
-        connect_nodes(not_g, 0, mux, 1);
+        // Move over the original pins to the first bank, copy them to the others.
+        if (bank == 0) {
+            remap_input_port_to_memory(banks[bank], new_addr, "addr");
+            remap_input_port_to_memory(banks[bank], signals->data, "data");
+        } else {
+            copy_input_port_to_memory(banks[bank], new_addr, "addr");
+            copy_input_port_to_memory(banks[bank], signals->data, "data");
+        }
 
-        npin_t *pin = signals->out->pins[i];
-        if (pin->name)
-            vtr::free(pin->name);
-        pin->name = mux->name;
+        add_memory_bank_we(banks[bank], bank_we[bank], "we");
 
-        if (pin->mapping)
-            vtr::free(pin->mapping);
-        pin->mapping = NULL;
+        if (bank == 0)
+            remap_input_port_to_memory(banks[bank], clk, "clk");
+        else
+            copy_input_port_to_memory(banks[bank], clk, "clk");
 
-        remap_pin_to_new_node(pin, mux, 0);
+        allocate_more_output_pins(banks[bank], signals->out->count);
+        add_output_port_information(banks[bank], signals->out->count);
 
-        connect_nodes(new_mem_node1, i, mux, 2);
-        if (new_mem_node1->output_pins[i]->mapping) {
-            vtr::free(new_mem_node1->output_pins[i]->mapping);
-        }
-        new_mem_node1->output_pins[i]->mapping = vtr::strdup("out");
-
-        connect_nodes(new_mem_node2, i, mux, 3);
-        if (new_mem_node2->output_pins[i]->mapping) {
-            vtr::free(new_mem_node2->output_pins[i]->mapping);
-        }
-        new_mem_node2->output_pins[i]->mapping = vtr::strdup("out");
+        sp_memory_list = insert_in_vptr_list(sp_memory_list, banks[bank]);
     }
 
+    mux_memory_banks(signals->out, banks, 0, bank_select, "out", node);
+
     free_sp_ram_signals(signals);
     free_signal_list(new_addr);
+    free_signal_list(clk);
 
     free_nnode(node);
-
-    split_sp_memory_depth(new_mem_node1, split_size);
-    split_sp_memory_depth(new_mem_node2, split_size);
 }
 
 /*-------------------------------------------------------------------------
  * (function: split_dp_memory_depth)
  *
  * This function works to split the depth of a dual port memory into
- *   several smaller memories.
+ *   several smaller memories, in one pass like split_sp_memory_depth.
  *------------------------------------------------------------------------
  */
 void split_dp_memory_depth(nnode_t *node, int split_size)
@@ -454,174 +475,68 @@ void split_dp_memory_depth(nnode_t *node, int split_size)
         return;
     }
 
-    signal_list_t *new_addr1 = init_signal_list();
+    int select_width = logical_size - split_size;
+    long num_banks = shift_left_value_with_overflow_check(0x1, select_width, node->loc);
 
     int i;
-    for (i = 1; i < signals->addr1->count; i++)
+    signal_list_t *new_addr1 = init_signal_list();
+    for (i = select_width; i < signals->addr1->count; i++)
         add_pin_to_signal_list(new_addr1, signals->addr1->pins[i]);
 
     signal_list_t *new_addr2 = init_signal_list();
-    for (i = 1; i < signals->addr2->count; i++)
+    for (i = select_width; i < signals->addr2->count; i++)
         add_pin_to_signal_list(new_addr2, signals->addr2->pins[i]);
 
-    /* Create the new memory node */
-    nnode_t *new_mem_node1 = allocate_nnode(node->loc);
-    nnode_t *new_mem_node2 = allocate_nnode(node->loc);
-
-    // Append the new name with an __S or __H
-    new_mem_node1->name = append_string(node->name, "__S");
-    new_mem_node2->name = append_string(node->name, "__H");
-
-    /* Copy properties from the original memory node */
-    new_mem_node1->type = node->type;
-    new_mem_node1->related_ast_node = node->related_ast_node;
-    new_mem_node1->traverse_visited = node->traverse_visited;
-    new_mem_node2->type = node->type;
-    new_mem_node2->related_ast_node = node->related_ast_node;
-    new_mem_node2->traverse_visited = node->traverse_visited;
-
-    // Move over the original pins to the first memory node.
     signal_list_t *clk = init_signal_list();
     add_pin_to_signal_list(clk, signals->clk);
-    remap_input_port_to_memory(new_mem_node1, new_addr1, "addr1");
-    remap_input_port_to_memory(new_mem_node1, new_addr2, "addr2");
-    remap_input_port_to_memory(new_mem_node1, signals->data1, "data1");
-    remap_input_port_to_memory(new_mem_node1, signals->data2, "data2");
-
-    // Copy the inputs to the second memory node.
-    copy_input_port_to_memory(new_mem_node2, new_addr1, "addr1");
-    copy_input_port_to_memory(new_mem_node2, new_addr2, "addr2");
-    copy_input_port_to_memory(new_mem_node2, signals->data1, "data1");
-    copy_input_port_to_memory(new_mem_node2, signals->data2, "data2");
-
-    // Hook up addresses and write enables.
-    {
-        signal_list_t *we;
-        nnode_t *and_node = make_2port_gate(LOGICAL_AND, 1, 1, 1, new_mem_node1, new_mem_node1->traverse_visited);
-        remap_pin_to_new_node(signals->we1, and_node, 1);
-        remap_pin_to_new_node(signals->addr1->pins[0], and_node, 0);
-
-        we = make_output_pins_for_existing_node(and_node, 1);
-        add_input_port_to_memory(new_mem_node1, we, "we1");
-        free_signal_list(we);
-
-        and_node = make_2port_gate(LOGICAL_AND, 1, 1, 1, new_mem_node1, new_mem_node1->traverse_visited);
-        remap_pin_to_new_node(signals->we2, and_node, 1);
-        remap_pin_to_new_node(signals->addr2->pins[0], and_node, 0);
-
-        we = make_output_pins_for_existing_node(and_node, 1);
-        add_input_port_to_memory(new_mem_node1, we, "we2");
-        free_signal_list(we);
-
-        nnode_t *not_g = make_not_gate_with_input(copy_input_npin(signals->addr1->pins[0]), new_mem_node2, new_mem_node2->traverse_visited);
-        and_node = make_2port_gate(LOGICAL_AND, 1, 1, 1, new_mem_node2, new_mem_node2->traverse_visited);
-        connect_nodes(not_g, 0, and_node, 0);
-        add_input_pin_to_node(and_node, copy_input_npin(signals->we1), 1);
-
-        we = make_output_pins_for_existing_node(and_node, 1);
-        add_input_port_to_memory(new_mem_node2, we, "we1");
-        free_signal_list(we);
-
-        not_g = make_not_gate_with_input(copy_input_npin(signals->addr2->pins[0]), new_mem_node2, new_mem_node2->traverse_visited);
-        and_node = make_2port_gate(LOGICAL_AND, 1, 1, 1, new_mem_node2, new_mem_node2->traverse_visited);
-        connect_nodes(not_g, 0, and_node, 0);
-
-        add_input_pin_to_node(and_node, copy_input_npin(signals->we2), 1);
-
-        we = make_output_pins_for_existing_node(and_node, 1);
-        add_input_port_to_memory(new_mem_node2, we, "we2");
-        free_signal_list(we);
-    }
-
-    // Add the clock signals.
-    remap_input_port_to_memory(new_mem_node1, clk, "clk");
-    copy_input_port_to_memory(new_mem_node2, clk, "clk");
-    free_signal_list(clk);
-
-    // Setup output ports on both nodes.
-    allocate_more_output_pins(new_mem_node1, signals->out1->count + signals->out2->count);
-    add_output_port_information(new_mem_node1, signals->out1->count);
-    add_output_port_information(new_mem_node1, signals->out2->count);
-
-    allocate_more_output_pins(new_mem_node2, signals->out1->count + signals->out2->count);
-    add_output_port_information(new_mem_node2, signals->out1->count);
-    add_output_port_information(new_mem_node2, signals->out2->count);
-
-    /* Copy over the output pins for the new memory */
-    for (i = 0; i < signals->data1->count; i++) {
-        nnode_t *mux = make_2port_gate(MUX_2, 2, 2, 1, new_mem_node1, new_mem_node1->traverse_visited);
-        nnode_t *not_g = make_not_gate(new_mem_node1, new_mem_node1->traverse_visited);
-        add_input_pin_to_node(mux, copy_input_npin(signals->addr1->pins[0]), 0);
-        add_input_pin_to_node(not_g, copy_input_npin(signals->addr1->pins[0]), 0);
-        connect_nodes(not_g, 0, mux, 1);
-
-        npin_t *pin = signals->out1->pins[i];
-        if (pin->name) {
-            vtr::free(pin->name);
-        }
-        pin->name = mux->name;
-        if (pin->mapping) {
-            vtr::free(pin->mapping);
-        }
-        pin->mapping = NULL;
-
-        remap_pin_to_new_node(pin, mux, 0);
-
-        connect_nodes(new_mem_node1, i, mux, 2);
-        if (new_mem_node1->output_pins[i]->mapping) {
-            vtr::free(new_mem_node1->output_pins[i]->mapping);
-        }
-        new_mem_node1->output_pins[i]->mapping = vtr::strdup("out1");
 
-        connect_nodes(new_mem_node2, i, mux, 3);
-        if (new_mem_node2->output_pins[i]->mapping) {
-            vtr::free(new_mem_node2->output_pins[i]->mapping);
+    // Decode the bank selects, the write enables take over the original pins.
+    std::vector<nnet_t *> bank_select1 = decode_address_banks(signals->addr1, 0, select_width, NULL, false, node, NULL);
+    std::vector<nnet_t *> bank_select2 = decode_address_banks(signals->addr2, 0, select_width, NULL, false, node, NULL);
+    std::vector<nnet_t *> bank_we1 = decode_address_banks(signals->addr1, 0, select_width, signals->we1, true, node, NULL);
+    std::vector<nnet_t *> bank_we2 = decode_address_banks(signals->addr2, 0, select_width, signals->we2, true, node, NULL);
+
+    std::vector<nnode_t *> banks(num_banks, NULL);
+    for (long bank = 0; bank < num_banks; bank++) {
+        banks[bank] = make_memory_bank(node, bank);
+
+        // Move over the original pins to the first bank, copy them to the others.
+        if (bank == 0) {
+            remap_input_port_to_memory(banks[bank], new_addr1, "addr1");
+            remap_input_port_to_memory(banks[bank], new_addr2, "addr2");
+            remap_input_port_to_memory(banks[bank], signals->data1, "data1");
+            remap_input_port_to_memory(banks[bank], signals->data2, "data2");
+        } else {
+            copy_input_port_to_memory(banks[bank], new_addr1, "addr1");
+            copy_input_port_to_memory(banks[bank], new_addr2, "addr2");
+            copy_input_port_to_memory(banks[bank], signals->data1, "data1");
+            copy_input_port_to_memory(banks[bank], signals->data2, "data2");
         }
-        new_mem_node2->output_pins[i]->mapping = vtr::strdup("out1");
-    }
-
-    /* Copy over the output pins for the new memory */
-    for (i = 0; i < signals->data1->count; i++) {
-        nnode_t *mux = make_2port_gate(MUX_2, 2, 2, 1, new_mem_node1, new_mem_node1->traverse_visited);
-        nnode_t *not_g = make_not_gate(new_mem_node1, new_mem_node1->traverse_visited);
-        add_input_pin_to_node(mux, copy_input_npin(signals->addr2->pins[0]), 0);
-        add_input_pin_to_node(not_g, copy_input_npin(signals->addr2->pins[0]), 0);
-        connect_nodes(not_g, 0, mux, 1);
-
-        int pin_index = new_mem_node1->output_port_sizes[0] + i;
 
-        npin_t *pin = signals->out2->pins[i];
-        if (pin->name) {
-            vtr::free(pin->name);
-        }
-        pin->name = mux->name;
-        if (pin->mapping) {
-            vtr::free(pin->mapping);
-        }
-        pin->mapping = NULL;
+        add_memory_bank_we(banks[bank], bank_we1[bank], "we1");
+        add_memory_bank_we(banks[bank], bank_we2[bank], "we2");
 
-        remap_pin_to_new_node(pin, mux, 0);
+        if (bank == 0)
+            remap_input_port_to_memory(banks[bank], clk, "clk");
+        else
+            copy_input_port_to_memory(banks[bank], clk, "clk");
 
-        connect_nodes(new_mem_node1, pin_index, mux, 2);
-        if (new_mem_node1->output_pins[pin_index]->mapping) {
-            vtr::free(new_mem_node1->output_pins[pin_index]->mapping);
-        }
-        new_mem_node1->output_pins[pin_index]->mapping = vtr::strdup("out2");
+        allocate_more_output_pins(banks[bank], signals->out1->count + signals->out2->count);
+        add_output_port_information(banks[bank], signals->out1->count);
+        add_output_port_information(banks[bank], signals->out2->count);
 
-        connect_nodes(new_mem_node2, pin_index, mux, 3);
-        if (new_mem_node2->output_pins[pin_index]->mapping) {
-            vtr::free(new_mem_node2->output_pins[pin_index]->mapping);
-        }
-        new_mem_node2->output_pins[pin_index]->mapping = vtr::strdup("out2");
+        dp_memory_list = insert_in_vptr_list(dp_memory_list, banks[bank]);
     }
 
+    mux_memory_banks(signals->out1, banks, 0, bank_select1, "out1", node);
+    mux_memory_banks(signals->out2, banks, signals->out1->count, bank_select2, "out2", node);
+
     free_dp_ram_signals(signals);
     free_signal_list(new_addr1);
     free_signal_list(new_addr2);
-    free_nnode(node);
+    free_signal_list(clk);
 
-    split_dp_memory_depth(new_mem_node1, split_size);
-    split_dp_memory_depth(new_mem_node2, split_size);
+    free_nnode(node);
 }
 
 /*
@@ -948,6 +863,136 @@ int get_dp_ram_split_width()
     }
 }
 
+/*-------------------------------------------------------------------------
+ * (function: collect_pb_type_memory_modes)
+ *
+ * Records the address and data widths of the single and dual port ram
+ *   primitives found under the given pb_type, one per mode of the
+ *   fracturable memory block.
+ *-----------------------------------------------------------------------*/
+static void collect_pb_type_memory_modes(t_pb_type *pb_type)
+{
+    if (pb_type->num_modes == 0) {
+        if (pb_type->model == NULL)
+            return;
+
+        bool sp = !strcmp(pb_type->model->name, SINGLE_PORT_RAM_string);
+        bool dp = !strcmp(pb_type->model->name, DUAL_PORT_RAM_string);
+        if (!sp && !dp)
+            return;
+
+        ram_mode_t mode = {0, 0};
+        for (int i = 0; i < pb_type->num_ports; i++) {
+            if (!strcmp(pb_type->ports[i].name, (sp) ? "addr" : "addr1"))
+                mode.addr_width = pb_type->ports[i].num_pins;
+            else if (!strcmp(pb_type->ports[i].name, (sp) ? "data" : "data1"))
+                mode.data_width = pb_type->ports[i].num_pins;
+        }
+
+        std::vector<ram_mode_t> &modes = (sp) ? sp_ram_modes : dp_ram_modes;
+        if (mode.addr_width <= 0 || mode.data_width <= 0)
+            return;
+        for (const ram_mode_t &known : modes) {
+            if (known.addr_width == mode.addr_width && known.data_width == mode.data_width)
+                return;
+        }
+        modes.push_back(mode);
+        return;
+    }
+
+    for (int i = 0; i < pb_type->num_modes; i++) {
+        for (int j = 0; j < pb_type->modes[i].num_pb_type_children; j++)
+            collect_pb_type_memory_modes(&pb_type->modes[i].pb_type_children[j]);
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * (function: collect_memory_modes)
+ *
+ * Collects the width/depth modes the memory blocks of the architecture
+ *   offer (e.g. 512x40, 1Kx20 and 2Kx10), used to plan the splitting of
+ *   the memories.
+ *-----------------------------------------------------------------------*/
+void collect_memory_modes(const std::vector<t_logical_block_type> &logical_block_types)
+{
+    sp_ram_modes.clear();
+    dp_ram_modes.clear();
+
+    for (const t_logical_block_type &block_type : logical_block_types) {
+        if (block_type.pb_type)
+            collect_pb_type_memory_modes(block_type.pb_type);
+    }
+}
+
+/*
+ * Returns the width of the named input port of the memory node.
+ */
+static int get_memory_port_size(nnode_t *node, const char *port_name)
+{
+    int port_number = get_input_port_index_from_mapping(node, port_name);
+    oassert(port_number != -1);
+
+    return node->input_port_sizes[port_number];
+}
+
+/*-------------------------------------------------------------------------
+ * (function: plan_memory_tiling)
+ *
+ * Picks the mode tiling a memory of 2^addr_width x data_width in the
+ *   fewest blocks: one per 2^mode address bits deep bank times one per
+ *   mode data width slice. Ties go to the mode with the fewest banks,
+ *   i.e. the shallowest output mux. Returns false without modes.
+ *-----------------------------------------------------------------------*/
+static bool plan_memory_tiling(const std::vector<ram_mode_t> &modes, long addr_width, long data_width, ram_mode_t *plan)
+{
+    long best_blocks = -1;
+    long best_banks = -1;
+
+    for (const ram_mode_t &mode : modes) {
+        long banks = shift_left_value_with_overflow_check(0x1, std::max(0L, addr_width - mode.addr_width), unknown_location);
+        long slices = (data_width + mode.data_width - 1) / mode.data_width;
+        long blocks = banks * slices;
+
+        if (best_blocks < 0 || blocks < best_blocks || (blocks == best_blocks && banks < best_banks)) {
+            best_blocks = blocks;
+            best_banks = banks;
+            *plan = mode;
+        }
+    }
+
+    return (best_blocks >= 0);
+}
+
+/*
+ * Determines the split depth of a memory from the mode the tiling planner
+ * picks for it, or the given split depth when it is configured or there are
+ * no modes.
+ */
+static long get_planned_split_depth(const std::vector<ram_mode_t> &modes, nnode_t *node, const char *addr_name, const char *data_name, long split_depth)
+{
+    ram_mode_t plan;
+    if (configuration.split_memory_depth != 0
+        || !plan_memory_tiling(modes, get_memory_port_size(node, addr_name), get_memory_port_size(node, data_name), &plan))
+        return split_depth;
+
+    return std::min<long>(plan.addr_width, split_depth);
+}
+
+/*
+ * Determines the split width of a memory from the mode the tiling planner
+ * picks for it, or the given split width when one bit slices are configured
+ * or there are no modes.
+ */
+static int get_planned_split_width(const std::vector<ram_mode_t> &modes, nnode_t *node, const char *addr_name, const char *data_name, int split_width)
+{
+    ram_mode_t plan;
+    if (configuration.split_memory_width
+        || !plan_memory_tiling(modes, get_memory_port_size(node, addr_name), get_memory_port_size(node, data_name), &plan))
+        return split_width;
+
+    return std::min(plan.data_width, split_width);
+}
+
 /*
  * Removes all memories from the sp_memory_list and dp_memory_list which do not
  * have more than configuration.soft_logic_memory_depth_threshold address bits.
@@ -1015,7 +1060,7 @@ void iterate_memories(netlist_t *netlist)
             oassert(node != NULL);
             oassert(node->type == MEMORY);
             temp = delete_in_vptr_list(temp);
-            split_sp_memory_depth(node, split_depth);
+            split_sp_memory_depth(node, get_planned_split_depth(sp_ram_modes, node, "addr", "data", split_depth));
         }
 
         // Width split
@@ -1027,7 +1072,7 @@ void iterate_memories(netlist_t *netlist)
             oassert(node != NULL);
             oassert(node->type == MEMORY);
             temp = delete_in_vptr_list(temp);
-            split_sp_memory_width(node, split_width);
+            split_sp_memory_width(node, get_planned_split_width(sp_ram_modes, node, "addr", "data", split_width));
         }
 
         // Remove memories that are too small to use hard blocks.
@@ -1056,7 +1101,7 @@ void iterate_memories(netlist_t *netlist)
             oassert(node != NULL);
             oassert(node->type == MEMORY);
             temp = delete_in_vptr_list(temp);
-            split_dp_memory_depth(node, split_depth);
+            split_dp_memory_depth(node, get_planned_split_depth(dp_ram_modes, node, "addr1", "data1", split_depth));
         }
 
         // Width split
@@ -1068,7 +1113,7 @@ void iterate_memories(netlist_t *netlist)
             oassert(node != NULL);
             oassert(node->type == MEMORY);
             temp = delete_in_vptr_list(temp);
-            split_dp_memory_width(node, split_width);
+            split_dp_memory_width(node, get_planned_split_width(dp_ram_modes, node, "addr1", "data1", split_width));
         }
 
         // Remove memories that are too small to use hard blocks.
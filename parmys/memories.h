@@ -25,6 +25,7 @@
 #define MEMORIES_H
 
 #include "odin_types.h"
+#include <vector>
 
 extern vtr::t_linked_vptr *sp_memory_list;
 extern vtr::t_linked_vptr *dp_memory_list;
@@ -54,12 +55,23 @@ struct dp_ram_signals {
     npin_t *clk;
 };
 
+/* a width/depth configuration a hard memory block of the architecture offers */
+struct ram_mode_t {
+    int addr_width;
+    int data_width;
+};
+
+extern std::vector<ram_mode_t> sp_ram_modes;
+extern std::vector<ram_mode_t> dp_ram_modes;
+
 extern sp_ram_signals *init_sp_ram_signals();
 extern dp_ram_signals *init_dp_ram_signals();
 
 long get_sp_ram_split_depth();
 long get_dp_ram_split_depth();
 
+void collect_memory_modes(const std::vector<t_logical_block_type> &logical_block_types);
+
 sp_ram_signals *get_sp_ram_signals(nnode_t *node);
 void free_sp_ram_signals(sp_ram_signals *signalsvar);
 
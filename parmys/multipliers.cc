@@ -31,12 +31,16 @@
 #include "read_xml_arch_file.h"
 #include <algorithm>
 #include <cmath>
+#include <map>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include "adders.h"
+#include "subtractions.h"
 
 #include "vtr_list.h"
 #include "vtr_memory.h"
@@ -61,8 +65,6 @@ void split_multiplier_b(nnode_t *node, int a, int b1, int b0);
 void pad_multiplier(nnode_t *node, netlist_t *netlist);
 void split_soft_multiplier(nnode_t *node, netlist_t *netlist);
 static mult_port_stat_e is_constant_multipication(nnode_t *node, netlist_t *netlist);
-static signal_list_t *implement_constant_multipication(nnode_t *node, mult_port_stat_e port_status, short mark, netlist_t *netlist);
-static nnode_t *perform_const_mult_optimization(mult_port_stat_e mult_port_stat, nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist);
 static void cleanup_mult_old_node(nnode_t *nodeo, netlist_t *netlist);
 
 // data structure representing a row of bits an adder tree
@@ -250,204 +252,953 @@ void instantiate_simple_soft_multiplier(nnode_t *node, short mark, netlist_t *ne
     }
 }
 
+/* a bit of a partial product column: the node driving it and the index of its output pin */
+typedef std::pair<nnode_t *, int> column_bit_t;
+
+/*---------------------------------------------------------------------------
+ * (function: next_dadda_height)
+ * 	Returns the largest height of the Dadda sequence (2, 3, 4, 6, 9, 13, ...)
+ * 	below height
+ *-------------------------------------------------------------------------*/
+static long next_dadda_height(long height)
+{
+    long target = 2;
+    while (target + target / 2 < height)
+        target += target / 2;
+
+    return target;
+}
+
+/*---------------------------------------------------------------------------
+ * (function: partial_product_heights)
+ * 	Number of partial product bits of a width_a x width_b multiplier falling
+ * 	in each of the width output columns
+ *-------------------------------------------------------------------------*/
+static std::vector<long> partial_product_heights(int width_a, int width_b, int width)
+{
+    std::vector<long> heights(width, 0);
+    for (int i = 0; i < width_b; i++) {
+        for (int j = 0; j < width_a && i + j < width; j++)
+            heights[i + j]++;
+    }
+
+    return heights;
+}
+
+/*---------------------------------------------------------------------------
+ * (function: estimate_soft_multiplier)
+ * 	Estimates the LUTs and the LUT levels of the soft multiplier of node
+ * 	built as an array (instantiate_simple_soft_multiplier) or as a Dadda
+ * 	tree (instantiate_tree_soft_multiplier). Every partial product, half
+ * 	adder and full adder output is counted as one LUT and one level, the
+ * 	final adders as ripple adders of one level per bit.
+ * 	These are model estimates only: the auto choice made from them has not
+ * 	been checked against mapped LUT counts and depths yet (bench.py run
+ * 	--only mult_array with -soft_mult array and -soft_mult tree), so auto
+ * 	is opt-in and array stays the default.
+ *-------------------------------------------------------------------------*/
+static void estimate_soft_multiplier(nnode_t *node, bool tree, long *luts, long *depth)
+{
+    int width_a = node->input_port_sizes[0];
+    int width_b = node->input_port_sizes[1];
+    int width = node->output_port_sizes[0];
+
+    std::vector<long> heights = partial_product_heights(width_a, width_b, width);
+    long partial_products = 0;
+    for (long height : heights)
+        partial_products += height;
+
+    if (!tree) {
+        /* width_b - 1 ripple adders of width_a + 1 bits, each one row below the previous one */
+        *luts = partial_products + 2 * (long)(width_b - 1) * (width_a + 1);
+        *depth = 1 + width_a + 2 * (long)(width_b - 1);
+        return;
+    }
+
+    long adders = 0;
+    int stages = 0;
+    long max_height = *std::max_element(heights.begin(), heights.end());
+    while (max_height > 2) {
+        long target = next_dadda_height(max_height);
+        for (int col = 0; col < width; col++) {
+            while (heights[col] > target) {
+                long reduce = (heights[col] - target >= 2) ? 2 : 1;
+                heights[col] -= reduce;
+                if (col + 1 < width)
+                    heights[col + 1]++;
+                adders++;
+            }
+        }
+        max_height = target;
+        stages++;
+    }
+
+    int first_column = 0;
+    while (first_column < width && heights[first_column] < 2)
+        first_column++;
+
+    *luts = partial_products + 2 * adders + 2 * (long)(width - first_column);
+    *depth = 1 + stages + (width - first_column);
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: estimate_soft_multiplier_cost)
+ * 	estimated LUT count and logic depth of the node built in soft logic with the
+ * 	architecture instantiate_soft_multiplier would pick for it. Booth, which auto
+ * 	uses for signed nodes, is costed as a tree
+ *-------------------------------------------------------------------------------------------*/
+void estimate_soft_multiplier_cost(nnode_t *node, long *luts, long *depth)
+{
+    std::string arch = global_args.soft_multiplier.value();
+    bool is_signed = (node->attributes->port_a_signed == SIGNED && node->attributes->port_b_signed == SIGNED);
+
+    long array_luts, array_depth, tree_luts, tree_depth;
+    estimate_soft_multiplier(node, false, &array_luts, &array_depth);
+    estimate_soft_multiplier(node, true, &tree_luts, &tree_depth);
+
+    bool tree = (arch == "tree" || arch == "booth");
+    if (arch == "auto")
+        tree = is_signed || (tree_depth < array_depth && tree_luts <= array_luts);
+    *luts = (tree) ? tree_luts : array_luts;
+    *depth = (tree) ? tree_depth : array_depth;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: hard_multiplier_fragments)
+ * 	the number of hard multipliers the node takes once iterate_multipliers has split it
+ * 	to the size of the hard block, the wider port of the block taking the wider operand.
+ * 	iterate_multipliers records it on the node as split_fragments before the split
+ *-------------------------------------------------------------------------------------------*/
+int hard_multiplier_fragments(nnode_t *node)
+{
+    if (hard_multipliers == NULL)
+        return 0;
+
+    int size_wide = std::max<int>(hard_multipliers->inputs->size, hard_multipliers->inputs->next->size);
+    int size_narrow = std::min<int>(hard_multipliers->inputs->size, hard_multipliers->inputs->next->size);
+    int mult_wide = std::max<int>(node->input_port_sizes[0], node->input_port_sizes[1]);
+    int mult_narrow = std::min<int>(node->input_port_sizes[0], node->input_port_sizes[1]);
+
+    return ((mult_wide + size_wide - 1) / size_wide) * ((mult_narrow + size_narrow - 1) / size_narrow);
+}
+
+/*---------------------------------------------------------------------------
+ * (function: instantiate_soft_multiplier)
+ * 	Builds node in soft logic as selected by -soft_mult. With auto, signed
+ * 	multipliers use radix-4 Booth, unsigned ones the Dadda tree if it is
+ * 	estimated to be shallower without taking more LUTs than the array.
+ * 	The array and the tree only compute unsigned products.
+ *-------------------------------------------------------------------------*/
+void instantiate_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist)
+{
+    std::string arch = global_args.soft_multiplier.value();
+    bool is_signed = (node->attributes->port_a_signed == SIGNED && node->attributes->port_b_signed == SIGNED);
+
+    if (is_signed && (arch == "booth" || arch == "auto")) {
+        instantiate_booth_soft_multiplier(node, mark, netlist);
+        return;
+    }
+
+    bool tree = (arch == "tree" || arch == "booth");
+
+    if (arch == "auto") {
+        long array_luts, array_depth, tree_luts, tree_depth;
+        estimate_soft_multiplier(node, false, &array_luts, &array_depth);
+        estimate_soft_multiplier(node, true, &tree_luts, &tree_depth);
+        tree = (tree_depth < array_depth && tree_luts <= array_luts);
+
+        Yosys::log("Soft multiplier %s (%dx%d): array ~%ld LUTs/%ld levels, tree ~%ld LUTs/%ld levels, using %s\n", node->name,
+                   node->input_port_sizes[0], node->input_port_sizes[1], array_luts, array_depth, tree_luts, tree_depth,
+                   (tree) ? "tree" : "array");
+    }
+
+    if (tree)
+        instantiate_tree_soft_multiplier(node, mark, netlist);
+    else
+        instantiate_simple_soft_multiplier(node, mark, netlist);
+}
+
+/*---------------------------------------------------------------------------
+ * (function: input_bit)
+ * 	Returns the driver of the net read by the input pin pin_idx of node,
+ * 	undriven inputs read ground like the soft adders do
+ *-------------------------------------------------------------------------*/
+static column_bit_t input_bit(nnode_t *node, int pin_idx, netlist_t *netlist)
+{
+    nnet_t *net = node->input_pins[pin_idx]->net;
+    if (net->num_driver_pins == 0 || net->driver_pins[0]->node == NULL)
+        return {netlist->gnd_node, 0};
+
+    return {net->driver_pins[0]->node, net->driver_pins[0]->pin_node_idx};
+}
+
+/*---------------------------------------------------------------------------
+ * (function: connect_bit_to_output)
+ * 	Drives the output pin idx of node with bit. If bit drives a net
+ * 	already, the fanouts of the output net are moved onto that net.
+ *-------------------------------------------------------------------------*/
+static void connect_bit_to_output(nnode_t *node, int idx, column_bit_t bit)
+{
+    npin_t *output_pin = node->output_pins[idx];
+    if (output_pin == NULL)
+        return;
+
+    npin_t *driver_pin = bit.first->output_pins[bit.second];
+    if (driver_pin == NULL) {
+        remap_pin_to_new_node(output_pin, bit.first, bit.second);
+    } else {
+        join_nets(driver_pin->net, output_pin->net);
+        free_npin(output_pin);
+        node->output_pins[idx] = NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------
+ * (function: sum_columns)
+ * 	Drives the outputs of node with the sum of the bits of columns, column
+ * 	i weighing 2^i. The columns are reduced Dadda style with full adders
+ * 	(ADDER_FUNC/CARRY_FUNC pairs) and half adders (LOGICAL_XOR/LOGICAL_AND
+ * 	pairs) until none holds more than two bits, each stage bringing them
+ * 	down to the next height of the Dadda sequence. A single ripple adder
+ * 	then adds the last two rows. Carries out of the top column are dropped.
+ *-------------------------------------------------------------------------*/
+static void sum_columns(nnode_t *node, std::vector<std::vector<column_bit_t>> &columns, short mark, netlist_t *netlist)
+{
+    int width = columns.size();
+
+    /* the carries of a column count in the next column of the same stage */
+    long max_height = 0;
+    for (auto &column : columns)
+        max_height = std::max<long>(max_height, column.size());
+
+    while (max_height > 2) {
+        long target = next_dadda_height(max_height);
+        for (int col = 0; col < width; col++) {
+            std::vector<column_bit_t> &column = columns[col];
+            std::vector<column_bit_t> reduced;
+            size_t next = 0;
+            long height = column.size();
+
+            while (height > target) {
+                int num_inputs = (height - target >= 2) ? 3 : 2;
+                nnode_t *sum = (num_inputs == 3) ? make_3port_gate(ADDER_FUNC, 1, 1, 1, 1, node, mark)
+                                                 : make_2port_gate(LOGICAL_XOR, 1, 1, 1, node, mark);
+                nnode_t *carry = NULL;
+                if (col + 1 < width)
+                    carry = (num_inputs == 3) ? make_3port_gate(CARRY_FUNC, 1, 1, 1, 1, node, mark)
+                                              : make_2port_gate(LOGICAL_AND, 1, 1, 1, node, mark);
+
+                for (int k = 0; k < num_inputs; k++) {
+                    connect_nodes(column[next + k].first, column[next + k].second, sum, k);
+                    if (carry)
+                        connect_nodes(column[next + k].first, column[next + k].second, carry, k);
+                }
+                next += num_inputs;
+                height -= num_inputs - 1;
+
+                reduced.push_back({sum, 0});
+                if (carry)
+                    columns[col + 1].push_back({carry, 0});
+            }
+
+            reduced.insert(reduced.end(), column.begin() + next, column.end());
+            column.swap(reduced);
+        }
+        max_height = target;
+    }
+
+    /* columns below the first one holding two bits are already final */
+    int first_column = 0;
+    while (first_column < width && columns[first_column].size() < 2)
+        first_column++;
+
+    for (int col = 0; col < first_column; col++) {
+        column_bit_t bit = (columns[col].empty()) ? column_bit_t(netlist->gnd_node, 0) : columns[col][0];
+        connect_bit_to_output(node, col, bit);
+    }
+
+    if (first_column == width)
+        return;
+
+    /* the final ripple adder of the two remaining rows */
+    int adder_width = width - first_column;
+    nnode_t *final_adder = make_2port_gate(ADD, adder_width, adder_width, adder_width, node, mark);
+    for (int col = first_column; col < width; col++) {
+        for (int row = 0; row < 2; row++) {
+            int pin = (col - first_column) + row * adder_width;
+            if (row < (int)columns[col].size())
+                connect_nodes(columns[col][row].first, columns[col][row].second, final_adder, pin);
+            else
+                add_input_pin_to_node(final_adder, get_zero_pin(netlist), pin);
+        }
+
+        remap_pin_to_new_node(node->output_pins[col], final_adder, col - first_column);
+    }
+
+    instantiate_add_w_carry(final_adder, mark, netlist);
+    free_nnode(final_adder);
+}
+
+/*---------------------------------------------------------------------------
+ * (function: detach_multiplier_inputs)
+ * 	Removes the input pins of node still connected from their nets
+ *-------------------------------------------------------------------------*/
+static void detach_multiplier_inputs(nnode_t *node)
+{
+    for (int i = 0; i < node->num_input_pins; i++) {
+        npin_t *pin = node->input_pins[i];
+        if (pin && pin->net)
+            remove_fanout_pin_unordered(pin->net, pin);
+    }
+}
+
+/*---------------------------------------------------------------------------
+ * (function: instantiate_tree_soft_multiplier)
+ * 	Builds node as a Dadda multiplier: the AND partial products of the
+ * 	output columns are summed up by sum_columns.
+ *-------------------------------------------------------------------------*/
+void instantiate_tree_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist)
+{
+    oassert(node->num_output_pins > 0);
+    oassert(node->num_input_pins > 0);
+    oassert(node->num_input_port_sizes == 2);
+    oassert(node->num_output_port_sizes == 1);
+
+    int width_a = node->input_port_sizes[0];
+    int width_b = node->input_port_sizes[1];
+    int width = node->output_port_sizes[0];
+
+    std::vector<std::vector<column_bit_t>> columns(width);
+
+    /* generate the AND partial products */
+    for (int i = 0; i < width_b; i++) {
+        column_bit_t bit_b = input_bit(node, width_a + i, netlist);
+        for (int j = 0; j < width_a && i + j < width; j++) {
+            column_bit_t bit_a = input_bit(node, j, netlist);
+            nnode_t *partial_product = make_1port_logic_gate(LOGICAL_AND, 2, node, mark);
+            connect_nodes(bit_b.first, bit_b.second, partial_product, 0);
+            connect_nodes(bit_a.first, bit_a.second, partial_product, 1);
+
+            columns[i + j].push_back({partial_product, 0});
+        }
+    }
+
+    detach_multiplier_inputs(node);
+    sum_columns(node, columns, mark, netlist);
+}
+
+/*---------------------------------------------------------------------------
+ * (function: instantiate_booth_soft_multiplier)
+ * 	Builds the signed multiplier node with radix-4 (modified) Booth
+ * 	recoding, halving the partial product rows. The narrower operand y is
+ * 	recoded in digits d_k = -2 y[2k+1] + y[2k] + y[2k-1] (y[-1] = 0, y sign
+ * 	extended), each selecting a row d_k * x of width_x + 1 bits:
+ *
+ * 		one_k = y[2k] ^ y[2k-1]
+ * 		two_k = (y[2k+1] ^ y[2k]) & ~one_k
+ * 		row_k[j] = ((one_k & x[j]) | (two_k & x[j-1])) ^ y[2k+1]
+ *
+ * 	The negation is completed by adding y[2k+1] at column 2k. Instead of
+ * 	sign extending the rows, the sign bit of each row is inverted and the
+ * 	constant -sum(2^(2k + width_x)) is added, which is exact modulo the
+ * 	output width. The rows are summed up by sum_columns.
+ *-------------------------------------------------------------------------*/
+void instantiate_booth_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist)
+{
+    oassert(node->num_output_pins > 0);
+    oassert(node->num_input_pins > 0);
+    oassert(node->num_input_port_sizes == 2);
+    oassert(node->num_output_port_sizes == 1);
+
+    int width = node->output_port_sizes[0];
+
+    /* recode the narrower operand */
+    bool recode_a = node->input_port_sizes[0] < node->input_port_sizes[1];
+    int width_x = node->input_port_sizes[(recode_a) ? 1 : 0];
+    int width_y = node->input_port_sizes[(recode_a) ? 0 : 1];
+    int offset_x = (recode_a) ? node->input_port_sizes[0] : 0;
+    int offset_y = (recode_a) ? 0 : node->input_port_sizes[0];
+
+    auto bit_x = [&](int j) {
+        return (j < 0) ? column_bit_t(netlist->gnd_node, 0) : input_bit(node, offset_x + std::min(j, width_x - 1), netlist);
+    };
+    auto bit_y = [&](int j) {
+        return (j < 0) ? column_bit_t(netlist->gnd_node, 0) : input_bit(node, offset_y + std::min(j, width_y - 1), netlist);
+    };
+    auto make_gate = [&](operation_list type, column_bit_t in_0, column_bit_t in_1) {
+        nnode_t *gate = make_2port_gate(type, 1, 1, 1, node, mark);
+        connect_nodes(in_0.first, in_0.second, gate, 0);
+        connect_nodes(in_1.first, in_1.second, gate, 1);
+        return gate;
+    };
+
+    std::vector<std::vector<column_bit_t>> columns(width);
+    std::vector<bool> sign_constant(width, false);
+
+    int num_rows = (width_y + 1) / 2;
+    for (int k = 0; k < num_rows && 2 * k < width; k++) {
+        column_bit_t neg = bit_y(2 * k + 1);
+
+        /* the Booth encoder of this digit */
+        nnode_t *one = make_gate(LOGICAL_XOR, bit_y(2 * k), bit_y(2 * k - 1));
+        nnode_t *not_one = make_gate(LOGICAL_XNOR, bit_y(2 * k), bit_y(2 * k - 1));
+        nnode_t *upper = make_gate(LOGICAL_XOR, neg, bit_y(2 * k));
+        nnode_t *two = make_gate(LOGICAL_AND, {upper, 0}, {not_one, 0});
+
+        for (int j = 0; j <= width_x && 2 * k + j < width; j++) {
+            /* one-hot select between x[j] and x[j-1] */
+            nnode_t *select = make_2port_gate(MUX_2, 2, 2, 1, node, mark);
+            connect_nodes(one, 0, select, 0);
+            connect_nodes(two, 0, select, 1);
+            column_bit_t data_0 = bit_x(j);
+            column_bit_t data_1 = bit_x(j - 1);
+            connect_nodes(data_0.first, data_0.second, select, 2);
+            connect_nodes(data_1.first, data_1.second, select, 3);
+
+            /* conditional inversion, the sign bit of the row is inverted */
+            nnode_t *row_bit = make_gate((j == width_x) ? LOGICAL_XNOR : LOGICAL_XOR, {select, 0}, neg);
+            columns[2 * k + j].push_back({row_bit, 0});
+        }
+
+        columns[2 * k].push_back(neg);
+
+        if (2 * k + width_x < width)
+            sign_constant[2 * k + width_x] = true;
+    }
+
+    /* add the two's complement of the inverted sign bits' weights */
+    bool carry = true;
+    for (int col = 0; col < width; col++) {
+        bool bit = !sign_constant[col];
+        if (bit != carry)
+            columns[col].push_back({netlist->vcc_node, 0});
+        carry = bit && carry;
+    }
+
+    detach_multiplier_inputs(node);
+    sum_columns(node, columns, mark, netlist);
+}
+
+/* one signed, shifted use of a partial product in a shift-and-add network */
+struct csd_term_t {
+    int base;  // index of the partial product, 0 is the variable operand itself
+    int shift; // left shift applied to it
+    int sign;  // +1 or -1
+};
+
+/* a shared partial product: base_a + sign * (base_b << shift) */
+struct csd_base_t {
+    int base_a;
+    int base_b;
+    int shift;
+    int sign;
+};
+
+/* a constant modulo 2^width, LSB first */
+typedef std::vector<bool> const_value_t;
+/* the nets of a value of the output width, LSB first */
+typedef std::vector<nnet_t *> const_bits_t;
+
+/* constant multiplications found by resolve, rewritten together once the traversal is done */
+static t_linked_vptr *const_mult_list = NULL;
+
+/**
+ * partial products already built, keyed by the variable operand (extended to the output width)
+ * and the constant they multiply it with. Multipliers sharing a variable operand reuse them,
+ * whether they multiply by the same constant or by constants with a common subexpression.
+ */
+static std::map<std::pair<const_bits_t, const_value_t>, const_bits_t> const_products;
+
+/*---------------------------------------------------------------------------------------------
+ * (function: constant_operand_value)
+ * 	reads the constant operand modulo 2^width, sign extended when the multiplication
+ * 	is signed (both operands signed)
+ *-------------------------------------------------------------------------------------------*/
+static const_value_t constant_operand_value(nnode_t *node, mult_port_stat_e port_status, int width, netlist_t *netlist)
+{
+    bool is_signed = (node->attributes->port_a_signed == SIGNED && node->attributes->port_b_signed == SIGNED);
+    int offset = (port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? node->input_port_sizes[0] : 0;
+    int port_width = node->input_port_sizes[(port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? 1 : 0];
+
+    const_value_t value(width, false);
+    for (int i = 0; i < width; i++) {
+        if (i < port_width)
+            value[i] = (node->input_pins[offset + i]->net == netlist->one_net);
+        else
+            value[i] = (is_signed && port_width > 0) ? value[port_width - 1] : false;
+    }
+
+    return value;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: variable_operand_bits)
+ * 	the nets of the variable operand extended to width, sign extended when the
+ * 	multiplication is signed
+ *-------------------------------------------------------------------------------------------*/
+static const_bits_t variable_operand_bits(nnode_t *node, mult_port_stat_e port_status, int width, netlist_t *netlist)
+{
+    bool is_signed = (node->attributes->port_a_signed == SIGNED && node->attributes->port_b_signed == SIGNED);
+    int offset = (port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? 0 : node->input_port_sizes[0];
+    int port_width = node->input_port_sizes[(port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? 0 : 1];
+
+    const_bits_t bits(width);
+    for (int i = 0; i < width; i++) {
+        if (i < port_width)
+            bits[i] = node->input_pins[offset + i]->net;
+        else
+            bits[i] = (is_signed && port_width > 0) ? bits[port_width - 1] : netlist->zero_net;
+    }
+
+    return bits;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: one_value)
+ *-------------------------------------------------------------------------------------------*/
+static const_value_t one_value(int width)
+{
+    const_value_t value(width, false);
+    value[0] = true;
+    return value;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: shift_add_value)
+ * 	a + sign * (b << shift) modulo 2^width
+ *-------------------------------------------------------------------------------------------*/
+static const_value_t shift_add_value(const const_value_t &a, const const_value_t &b, int shift, int sign)
+{
+    int width = a.size();
+    const_value_t result(width, false);
+
+    /* subtraction is a + ~(b << shift) + 1 */
+    int carry = (sign < 0) ? 1 : 0;
+    for (int i = 0; i < width; i++) {
+        bool bit_b = (i >= shift) ? b[i - shift] : false;
+        if (sign < 0)
+            bit_b = !bit_b;
+
+        int sum = a[i] + bit_b + carry;
+        result[i] = sum & 1;
+        carry = sum >> 1;
+    }
+
+    return result;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: csd_recode)
+ * 	recodes the constant into canonical signed digits, no two adjacent digits are non-zero.
+ * 	Only the digits below the width are kept since the product is taken modulo 2^width.
+ *-------------------------------------------------------------------------------------------*/
+static void csd_recode(const const_value_t &value, std::vector<csd_term_t> &terms)
+{
+    int width = value.size();
+    int carry = 0;
+
+    for (int i = 0; i < width; i++) {
+        int digit = value[i] + carry;
+        int next = (i + 1 < width) ? value[i + 1] : 0;
+
+        if (digit == 1 && next == 1) {
+            /* a run of ones: 0111 = 1000 - 0001 */
+            terms.push_back({0, i, -1});
+            carry = 1;
+        } else if (digit == 1) {
+            terms.push_back({0, i, 1});
+            carry = 0;
+        } else {
+            carry = (digit == 2) ? 1 : 0;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: csd_pattern)
+ * 	the pattern formed by two terms, with term a the one of the lowest shift
+ *-------------------------------------------------------------------------------------------*/
+static csd_base_t csd_pattern(const csd_term_t &a, const csd_term_t &b) { return {a.base, b.base, b.shift - a.shift, a.sign * b.sign}; }
+
+static bool operator<(const csd_base_t &a, const csd_base_t &b)
+{
+    return std::tie(a.base_a, a.base_b, a.shift, a.sign) < std::tie(b.base_a, b.base_b, b.shift, b.sign);
+}
+
+static bool operator==(const csd_base_t &a, const csd_base_t &b) { return !(a < b) && !(b < a); }
+
+/*---------------------------------------------------------------------------------------------
+ * (function: match_csd_pattern)
+ * 	greedily pairs up the terms forming the pattern, a term is used at most once
+ *-------------------------------------------------------------------------------------------*/
+static std::vector<std::pair<int, int>> match_csd_pattern(const std::vector<csd_term_t> &terms, const csd_base_t &pattern)
+{
+    std::vector<std::pair<int, int>> matches;
+    std::vector<bool> used(terms.size(), false);
+
+    for (size_t i = 0; i < terms.size(); i++) {
+        for (size_t j = i + 1; j < terms.size() && !used[i]; j++) {
+            if (!used[j] && csd_pattern(terms[i], terms[j]) == pattern) {
+                used[i] = used[j] = true;
+                matches.push_back({i, j});
+            }
+        }
+    }
+
+    return matches;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: share_csd_subexpressions)
+ * 	common subexpression elimination over the signed digits of one or more constants
+ * 	multiplying the same operand. As long as a pair of terms (e.g. x + x << 2) shows up
+ * 	at least twice, in one constant or across them, it becomes a new partial product
+ * 	built once and the pairs are replaced by shifted uses of it. Each round saves one
+ * 	adder per extra occurrence.
+ *-------------------------------------------------------------------------------------------*/
+static void share_csd_subexpressions(std::vector<std::vector<csd_term_t>> &term_sets, std::vector<csd_base_t> &bases)
+{
+    while (true) {
+        /* every pair occurrence, an upper bound on the pairs that can be used at once */
+        std::map<csd_base_t, int> occurrences;
+        for (std::vector<csd_term_t> &terms : term_sets) {
+            std::sort(terms.begin(), terms.end(), [](const csd_term_t &a, const csd_term_t &b) {
+                return std::tie(a.shift, a.base) < std::tie(b.shift, b.base);
+            });
+
+            for (size_t i = 0; i < terms.size(); i++)
+                for (size_t j = i + 1; j < terms.size(); j++)
+                    occurrences[csd_pattern(terms[i], terms[j])]++;
+        }
+
+        std::vector<std::pair<csd_base_t, int>> candidates(occurrences.begin(), occurrences.end());
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const std::pair<csd_base_t, int> &a, const std::pair<csd_base_t, int> &b) { return a.second > b.second; });
+
+        csd_base_t best = {0, 0, 0, 0};
+        std::vector<std::vector<std::pair<int, int>>> best_matches;
+        size_t best_count = 1;
+        for (const auto &candidate : candidates) {
+            if ((size_t)candidate.second <= best_count)
+                break;
+
+            std::vector<std::vector<std::pair<int, int>>> matches;
+            size_t count = 0;
+            for (const std::vector<csd_term_t> &terms : term_sets) {
+                matches.push_back(match_csd_pattern(terms, candidate.first));
+                count += matches.back().size();
+            }
+
+            if (count > best_count) {
+                best = candidate.first;
+                best_matches = matches;
+                best_count = count;
+            }
+        }
+
+        if (best_matches.empty())
+            break;
+
+        /* the new partial product, bases[0] stands for the variable operand */
+        int new_base = bases.size();
+        bases.push_back(best);
+
+        for (size_t set = 0; set < term_sets.size(); set++) {
+            std::vector<csd_term_t> &terms = term_sets[set];
+            std::vector<bool> removed(terms.size(), false);
+            for (const auto &match : best_matches[set]) {
+                terms[match.first].base = new_base;
+                removed[match.second] = true;
+            }
+
+            std::vector<csd_term_t> remaining;
+            for (size_t i = 0; i < terms.size(); i++) {
+                if (!removed[i])
+                    remaining.push_back(terms[i]);
+            }
+            terms = remaining;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: plan_constant_multipliers)
+ * 	builds the shift-and-add plan of constants multiplying the same operand: the partial
+ * 	products in bases (bases[0] is the variable operand), shared by all of them, and the
+ * 	signed, shifted terms to sum for each constant. Returns the number of adders.
+ *-------------------------------------------------------------------------------------------*/
+static int plan_constant_multipliers(const std::vector<const_value_t> &values, std::vector<std::vector<csd_term_t>> &term_sets,
+                                     std::vector<csd_base_t> &bases)
+{
+    term_sets.assign(values.size(), std::vector<csd_term_t>());
+    bases.assign(1, {0, 0, 0, 1});
+
+    for (size_t i = 0; i < values.size(); i++)
+        csd_recode(values[i], term_sets[i]);
+    share_csd_subexpressions(term_sets, bases);
+
+    int adders = bases.size() - 1;
+    for (const std::vector<csd_term_t> &terms : term_sets) {
+        if (terms.empty())
+            continue;
+
+        bool has_positive = std::any_of(terms.begin(), terms.end(), [](const csd_term_t &term) { return term.sign > 0; });
+
+        /* a product with only negative terms needs a final negation */
+        adders += (terms.size() - 1) + (has_positive ? 0 : 1);
+    }
+
+    return adders;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: plan_constant_multipication)
+ * 	the number of adders of a constant on its own
+ *-------------------------------------------------------------------------------------------*/
+static int plan_constant_multipication(const const_value_t &value)
+{
+    std::vector<std::vector<csd_term_t>> term_sets;
+    std::vector<csd_base_t> bases;
+    return plan_constant_multipliers(std::vector<const_value_t>(1, value), term_sets, bases);
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: build_shift_add)
+ * 	(a << shift_a) + sign * (b << shift_b) as an ADD or a MINUS node of the output width.
+ * 	The nodes go through the same port checks as the ones resolve finds in the netlist,
+ * 	so they map onto hard adder chains whenever the architecture has them.
+ *-------------------------------------------------------------------------------------------*/
+static const_bits_t build_shift_add(const const_bits_t &a, int shift_a, const const_bits_t &b, int shift_b, int sign, nnode_t *node, short mark,
+                                    netlist_t *netlist)
+{
+    int width = a.size();
+    nnode_t *add_node = make_2port_gate((sign < 0) ? MINUS : ADD, width, width, width, node, mark);
+
+    for (int i = 0; i < width; i++) {
+        add_input_pin_to_node(add_node, make_fanout_pin((i >= shift_a) ? a[i - shift_a] : netlist->zero_net), i);
+        add_input_pin_to_node(add_node, make_fanout_pin((i >= shift_b) ? b[i - shift_b] : netlist->zero_net), width + i);
+    }
+
+    const_bits_t result(width);
+    for (int i = 0; i < width; i++) {
+        npin_t *out_pin = allocate_npin();
+        nnet_t *out_net = allocate_nnet();
+        out_net->name = make_full_ref_name(NULL, NULL, NULL, add_node->name, i);
+        /* hook the output pin into the node */
+        add_output_pin_to_node(add_node, out_pin, i);
+        /* hook up the output pin into the new net */
+        add_driver_pin_to_net(out_net, out_pin);
+
+        result[i] = out_net;
+    }
+
+    if (sign < 0) {
+        equalize_ports_size(add_node, mark, netlist);
+        sub_list = insert_in_vptr_list(sub_list, add_node);
+    } else {
+        if (hard_adders)
+            add_node = check_missing_ports(add_node, mark, netlist);
+        add_list = insert_in_vptr_list(add_list, add_node);
+    }
+
+    return result;
+}
+
+/* an operand of the final sum: sign * (bits << shift), value is the unshifted constant */
+struct csd_operand_t {
+    int sign;
+    int shift;
+    const_value_t value;
+    const_bits_t bits;
+};
+
+/*---------------------------------------------------------------------------------------------
+ * (function: shared_shift_add)
+ * 	(a << (shift_a - shift)) + sign * (b << (shift_b - shift)) with shift the lowest of the
+ * 	two, reusing the partial product when it was already built for the same variable operand
+ *-------------------------------------------------------------------------------------------*/
+static csd_operand_t shared_shift_add(const const_bits_t &x, const csd_operand_t &a, const csd_operand_t &b, int sign, nnode_t *node, short mark,
+                                      netlist_t *netlist)
+{
+    int shift = std::min(a.shift, b.shift);
+    const_value_t zero(a.value.size(), false);
+
+    csd_operand_t result;
+    result.sign = a.sign;
+    result.shift = shift;
+    result.value = shift_add_value(shift_add_value(zero, a.value, a.shift - shift, 1), b.value, b.shift - shift, sign);
+
+    auto key = std::make_pair(x, result.value);
+    auto cached = const_products.find(key);
+    if (cached != const_products.end()) {
+        result.bits = cached->second;
+    } else {
+        result.bits = build_shift_add(a.bits, a.shift - shift, b.bits, b.shift - shift, sign, node, mark, netlist);
+        const_products[key] = result.bits;
+    }
+
+    return result;
+}
+
 /**
  * --------------------------------------------------------------------------
  * (function: implement_constant_multipication)
  *
- * @brief implementing constant multipication utilizing shift and ADD operations
+ * @brief implementing constant multipication utilizing shift and ADD operations.
+ * The signed terms of the recoded constant are summed by a balanced tree of
+ * adders and subtractors over the partial products of its group.
  *
  * @note this function should call before partial mapping phase
  * since some logic need to be softened
  *
  * @param node pointer to the multipication netlist node
- * @param port_status showing which value is constant, which is variable
+ * @param x the variable operand extended to the width of the group
+ * @param terms the signed, shifted partial products to sum
+ * @param partial_products the partial products shared by the group
  * @param mark a unique DFS traversal number
  * @param netlist pointer to the current netlist
  *
  * @return output signal
  * -------------------------------------------------------------------------*/
-static signal_list_t *implement_constant_multipication(nnode_t *node, mult_port_stat_e port_status, short mark, netlist_t *netlist)
+static signal_list_t *implement_constant_multipication(nnode_t *node, const const_bits_t &x, const std::vector<csd_term_t> &terms,
+                                                       const std::vector<csd_operand_t> &partial_products, short mark, netlist_t *netlist)
 {
     /* validate the port sizes */
     oassert(node->num_input_port_sizes == 2);
     oassert(node->num_output_port_sizes == 1);
 
-    signal_list_t *return_value = init_signal_list();
+    /* the low bits of the product do not depend on the bits above them */
+    int width = node->num_output_pins;
+    oassert(width <= (int)x.size());
+
+    /* positive terms first so the sum only needs a final negation if every term is negative */
+    std::vector<csd_operand_t> operands;
+    for (const csd_term_t &term : terms)
+        operands.push_back({term.sign, term.shift, partial_products[term.base].value, partial_products[term.base].bits});
+    std::stable_sort(operands.begin(), operands.end(), [](const csd_operand_t &a, const csd_operand_t &b) { return a.sign > b.sign; });
+
+    /* balanced adder tree, the first operand of each pair keeps its sign */
+    while (operands.size() > 1) {
+        std::vector<csd_operand_t> next_level;
+        for (size_t i = 0; i + 1 < operands.size(); i += 2)
+            next_level.push_back(shared_shift_add(x, operands[i], operands[i + 1], operands[i].sign * operands[i + 1].sign, node, mark, netlist));
+        if (operands.size() % 2)
+            next_level.push_back(operands.back());
+        operands = next_level;
+    }
 
-    /**
-     * Multiply ports
-     * IN1: (n bits)        input_port[0]
-     * IN2: (m bits)        input_port[1]
-     * OUT: min(m, n) bits  output_port[0]
-     */
+    const_bits_t product(x.size(), netlist->zero_net);
+    if (!operands.empty()) {
+        csd_operand_t sum = operands[0];
+        if (sum.sign < 0) {
+            /* 0 - sum */
+            csd_operand_t zero = {1, 0, const_value_t(x.size(), false), product};
+            sum = shared_shift_add(x, zero, sum, -1, node, mark, netlist);
+        }
 
-    int IN1_width = node->input_port_sizes[0];
+        for (int i = sum.shift; i < (int)x.size(); i++)
+            product[i] = sum.bits[i - sum.shift];
+    }
 
-    int i, j;
-    int const_operand_offset = (port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? IN1_width : 0;
-    int const_operand_width = node->input_port_sizes[(port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? 1 : 0];
+    signal_list_t *return_value = init_signal_list();
+    for (int i = 0; i < width; i++)
+        add_pin_to_signal_list(return_value, make_fanout_pin(product[i]));
+
+    return (return_value);
+}
 
-    int variable_operand_offset = (port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? 0 : IN1_width;
-    int variable_operand_width = node->num_input_pins - const_operand_width;
-    operation_list variable_operand_signedness =
-      (port_status == mult_port_stat_e::MULTIPICAND_CONSTANT) ? node->attributes->port_a_signed : node->attributes->port_b_signed;
+/**
+ * --------------------------------------------------------------------------
+ * (function: implement_constant_multiplier_group)
+ *
+ * @brief the multiple constant multiplication block: multipliers reading the
+ * same variable operand are planned together, so the subexpressions of all
+ * their constants are built once at the widest output width. With hard
+ * multipliers in the architecture, the group is moved off the DSP blocks if
+ * it costs at most -const_mult_adders adders per multiplier, otherwise only
+ * the constants that are cheap on their own are; the others are handed back
+ * to the hard multiplier flow.
+ *
+ * @param nodes the multiplications of the group
+ * @param netlist pointer to the current netlist
+ * -------------------------------------------------------------------------*/
+static void implement_constant_multiplier_group(std::vector<nnode_t *> &nodes, netlist_t *netlist)
+{
+    std::vector<mult_port_stat_e> port_status;
+    int width = 0;
+    for (nnode_t *node : nodes) {
+        port_status.push_back(is_constant_multipication(node, netlist));
+        width = std::max(width, (int)node->num_output_pins);
+    }
 
-    /* after each level one bit will be added to the width of results */
-    int width = node->num_output_pins;
+    std::vector<const_value_t> values;
+    std::vector<int> separate_adders;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        values.push_back(constant_operand_value(nodes[i], port_status[i], width, netlist));
+        separate_adders.push_back(plan_constant_multipication(values.back()));
+    }
 
-    /* container for constatnt operand */
-    signal_list_t *const_operand = init_signal_list();
-    for (i = 0; i < const_operand_width; i++) {
-        add_pin_to_signal_list(const_operand, node->input_pins[const_operand_offset + i]);
-    }
-    /* container for variable operand */
-    signal_list_t *variable_operand = init_signal_list();
-    for (i = 0; i < variable_operand_width; i++) {
-        add_pin_to_signal_list(variable_operand, node->input_pins[variable_operand_offset + i]);
-    }
-
-    /* netlist GND and VCC net */
-    nnet_t *gnd_net = netlist->zero_net;
-    nnet_t *vcc_net = netlist->one_net;
-
-    int internal_outputs_size = const_operand_width;
-    /* to keep the record of internal outputs for connection purposes */
-    signal_list_t **internal_outputs = (signal_list_t **)vtr::calloc(internal_outputs_size, sizeof(signal_list_t *));
-    /* implementing the multipication using shift and add operation */
-    for (i = 0; i < node->num_output_pins + 1; i++) {
-        npin_t *pin;
-        /* checking a couple conditions to avoid going further if there is not needed */
-        if (i == node->num_output_pins || i == const_operand_width) {
-            internal_outputs_size = i;
-            /* initializing the return value */
-            for (j = 0; j < internal_outputs[i - 1]->count; j++) {
-                add_pin_to_signal_list(return_value, internal_outputs[i - 1]->pins[j]);
-            }
-            break;
-        } else {
-            pin = const_operand->pins[i];
-        }
-        /* init the interanl outputs signal list */
-        internal_outputs[i] = init_signal_list();
-
-        /* if the pin is GND we pass */
-        if (!strcmp(pin->net->name, gnd_net->name)) {
-            for (j = 0; j < width; j++) {
-                /* if the first bit of const_operand is zero we need to initiate the multipication by zero pins */
-                npin_t *internal_output_pin = (i == 0) ? get_zero_pin(netlist) : internal_outputs[i - 1]->pins[j];
-                add_pin_to_signal_list(internal_outputs[i], internal_output_pin);
+    std::vector<std::vector<csd_term_t>> term_sets;
+    std::vector<csd_base_t> bases;
+    int adders = plan_constant_multipliers(values, term_sets, bases);
+
+    if (hard_multipliers && adders > global_args.const_mult_adders * (int)nodes.size()) {
+        std::vector<nnode_t *> kept_nodes;
+        std::vector<mult_port_stat_e> kept_status;
+        std::vector<const_value_t> kept_values;
+        std::vector<int> kept_adders;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (separate_adders[i] <= global_args.const_mult_adders) {
+                kept_nodes.push_back(nodes[i]);
+                kept_status.push_back(port_status[i]);
+                kept_values.push_back(values[i]);
+                kept_adders.push_back(separate_adders[i]);
+            } else {
+                /* back to the hard multipliers */
+                check_multiplier_port_size(nodes[i]);
+                mult_list = insert_in_vptr_list(mult_list, nodes[i]);
             }
         }
-        /* the const_operand pin is connected to VCC */
-        else if (!strcmp(pin->net->name, vcc_net->name)) {
-            /* for the first round we do not need to shift */
-            if (i == 0) {
-                for (j = 0; j < width; j++) {
-                    if (j < variable_operand_width) {
-                        add_pin_to_signal_list(internal_outputs[0], copy_input_npin(variable_operand->pins[j]));
-                    } else {
-                        add_pin_to_signal_list(internal_outputs[0], get_zero_pin(netlist));
-                    }
-                }
-            } else {
-                /*****************************************************************************************/
-                /*************************************** SHIFT_NODE **************************************/
-                /*****************************************************************************************/
-                /**
-                 * create a shift node to shift the variable port based on the i idx
-                 *
-                 * (shift node)
-                 * IN1: variable_operand of the multiplier
-                 * IN2: shift value (const_operand_width maximum size)
-                 * OUT: shifted IN1 (width)
-                 *
-                 */
-                nnode_t *shift_node = make_2port_gate(SL, width, width, width, node, mark);
-                /* connecting the shift value pins */
-                signal_list_t *shift_value = create_constant_signal(i, width, netlist);
-
-                /* keeping the shift output nodes for adding with the previous stage internal outputs */
-                signal_list_t *shift_outputs = init_signal_list();
-
-                int pad_pin = variable_operand->count - 1;
-                for (j = 0; j < width; j++) {
-                    if (j < variable_operand_width) {
-                        /* connecing the first input of the shift node */
-                        add_input_pin_to_node(shift_node, copy_input_npin(variable_operand->pins[j]), j);
-                    } else {
-                        add_input_pin_to_node(
-                          shift_node,
-                          (variable_operand_signedness == SIGNED) ? copy_input_npin(variable_operand->pins[pad_pin]) : get_zero_pin(netlist), j);
-                    }
-
-                    /* hook shift value pins into the shift node */
-                    add_input_pin_to_node(shift_node, shift_value->pins[j], width + j);
-
-                    /* Specifying the level_muxes outputs */
-                    // Connect output pin to related input pin
-                    npin_t *var_op_out1 = allocate_npin();
-                    npin_t *var_op_out2 = allocate_npin();
-                    nnet_t *var_op_net = allocate_nnet();
-                    var_op_net->name = make_full_ref_name(NULL, NULL, NULL, shift_node->name, j);
-                    /* hook the output pin into the node */
-                    add_output_pin_to_node(shift_node, var_op_out1, j);
-                    /* hook up new pin 1 into the new net */
-                    add_driver_pin_to_net(var_op_net, var_op_out1);
-                    /* hook up the new pin 2 to this new net */
-                    add_fanout_pin_to_net(var_op_net, var_op_out2);
-
-                    /* adding the output pin to the shoft output signal container */
-                    add_pin_to_signal_list(shift_outputs, var_op_out2);
-                }
 
-                /*****************************************************************************************/
-                /**************************************** ADD_NODE ***************************************/
-                /*****************************************************************************************/
-                nnode_t *add_node = make_2port_gate(ADD, width, width, width, node, mark);
-                add_list = insert_in_vptr_list(add_list, add_node);
-                /* connecting add node input pins */
-                for (j = 0; j < width; j++) {
-                    /* connecting the previous stage internal outputs as the first add inputs */
-                    add_input_pin_to_node(add_node, internal_outputs[i - 1]->pins[j], j);
-
-                    /* connecting the shift output pins as the second input */
-                    add_input_pin_to_node(add_node, shift_outputs->pins[j], width + j);
-
-                    /* creating new output pins and adding to the internal outputs for next stages */
-                    // Connect output pin to related input pin
-                    npin_t *add_op_out1 = allocate_npin();
-                    npin_t *add_op_out2 = allocate_npin();
-                    nnet_t *add_op_net = allocate_nnet();
-                    add_op_net->name = make_full_ref_name(NULL, NULL, NULL, add_node->name, j);
-                    /* hook the output pin into the node */
-                    add_output_pin_to_node(add_node, add_op_out1, j);
-                    /* hook up new pin 1 into the new net */
-                    add_driver_pin_to_net(add_op_net, add_op_out1);
-                    /* hook up the new pin 2 to this new net */
-                    add_fanout_pin_to_net(add_op_net, add_op_out2);
-
-                    /* adding the output pin to the shoft output signal container */
-                    add_pin_to_signal_list(internal_outputs[i], add_op_out2);
-                }
+        nodes = kept_nodes;
+        port_status = kept_status;
+        values = kept_values;
+        separate_adders = kept_adders;
+        adders = plan_constant_multipliers(values, term_sets, bases);
+    }
 
-                // CLEAN UP
-                free_signal_list(shift_value);
-                free_signal_list(shift_outputs);
-            }
-        }
+    if (nodes.empty())
+        return;
+
+    short mark = static_cast<short>(nodes[0]->traverse_visited);
+    const_bits_t x = variable_operand_bits(nodes[0], port_status[0], width, netlist);
+
+    /* building the shared partial products, bases[0] is the variable operand */
+    std::vector<csd_operand_t> partial_products(bases.size());
+    partial_products[0] = {1, 0, one_value(width), x};
+    for (size_t i = 1; i < bases.size(); i++) {
+        const csd_base_t &base = bases[i];
+        const csd_operand_t &shifted = partial_products[base.base_b];
+        partial_products[i] =
+          shared_shift_add(x, partial_products[base.base_a], {1, base.shift, shifted.value, shifted.bits}, base.sign, nodes[0], mark, netlist);
     }
 
-    // CLEAN UP
-    free_signal_list(const_operand);
-    free_signal_list(variable_operand);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        /* implementation of constant multipication which is actually cascading adders */
+        signal_list_t *output_signals = implement_constant_multipication(nodes[i], x, term_sets[i], partial_products, mark, netlist);
 
-    for (i = 0; i < internal_outputs_size; i++) {
-        if (internal_outputs[i])
-            free_signal_list(internal_outputs[i]);
+        /* connecting the output pins */
+        connect_constant_mult_outputs(nodes[i], output_signals);
     }
-    vtr::free(internal_outputs);
 
-    return (return_value);
+    if (nodes.size() > 1) {
+        int adders_alone = 0;
+        for (int count : separate_adders)
+            adders_alone += count;
+
+        Yosys::log("Constant multiplier group of %s: %zu multipliers, %d adders (%d without sharing), %zu hard multipliers saved\n",
+                   nodes[0]->name, nodes.size(), adders, adders_alone, hard_multipliers ? nodes.size() : (size_t)0);
+    }
 }
 
 /**
@@ -486,7 +1237,7 @@ void connect_constant_mult_outputs(nnode_t *node, signal_list_t *output_signal_l
         npin_t *pin = node->input_pins[i];
 
         /* detach from input nets */
-        remove_fanout_pins_from_net(pin->net, pin, pin->pin_net_idx);
+        remove_fanout_pin_unordered(pin->net, pin);
 
         /* free pin */
         free_npin(node->input_pins[i]);
@@ -685,11 +1436,13 @@ void add_the_blackbox_for_mults_yosys(Yosys::Design *design)
 
         Yosys::hashlib::dict<Yosys::RTLIL::IdString, std::pair<int, bool>> wideports_cache;
 
+        if (blackbox_defined(design, Yosys::RTLIL::escape_id(mul_name))) {
+            muls = muls->next;
+            continue;
+        }
+
         module = new Yosys::RTLIL::Module;
         module->name = Yosys::RTLIL::escape_id(mul_name);
-
-        if (design->module(module->name))
-            Yosys::log_error("Duplicate definition of module %s!\n", Yosys::log_id(module->name));
         design->add(module);
 
         /* add the inputs */
@@ -771,58 +1524,15 @@ void define_mult_function_yosys(nnode_t *node, Yosys::Module *module, Yosys::Des
     Yosys::IdString celltype = Yosys::RTLIL::escape_id(cell_type_name);
     Yosys::RTLIL::Cell *cell = module->addCell(NEW_ID, celltype);
 
-    Yosys::hashlib::dict<Yosys::RTLIL::IdString, Yosys::hashlib::dict<int, Yosys::SigBit>> cell_wideports_cache;
-
-    for (int i = 0; i < node->num_input_pins; i++) {
-        std::string p, q;
-        if (i < node->input_port_sizes[flip ? 1 : 0]) {
-            int input_index = flip ? i + node->input_port_sizes[0] : i;
-            nnet_t *net = node->input_pins[input_index]->net;
-            oassert(net->num_driver_pins == 1);
-            npin_t *driver_pin = net->driver_pins[0];
-
-            p = Yosys::stringf("%s[%d]", hard_multipliers->inputs->next->name, i);
+    for (int i = 0; i < node->num_input_pins; i++)
+        oassert(node->input_pins[i]->net->num_driver_pins == 1);
 
-            if (!driver_pin->name)
-                q = driver_pin->node->name;
-            else
-                q = driver_pin->name;
-        } else {
-            int input_index = flip ? i - node->input_port_sizes[1] : i;
-            nnet_t *net = node->input_pins[input_index]->net;
-            oassert(net->num_driver_pins == 1);
-            npin_t *driver_pin = net->driver_pins[0];
-
-            long index = flip ? i - node->input_port_sizes[1] : i - node->input_port_sizes[0];
-
-            p = Yosys::stringf("%s[%ld]", hard_multipliers->inputs->name, index);
-
-            if (!driver_pin->name)
-                q = driver_pin->node->name;
-            else
-                q = driver_pin->name;
-        }
-
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(p);
-        if (wp.first.empty())
-            cell->setPort(Yosys::RTLIL::escape_id(p), to_wire(q, module));
-        else
-            cell_wideports_cache[wp.first][wp.second] = to_wire(q, module);
-    }
+    Yosys::SigSpec sig_a = input_port_sig(module, node, 0, node->input_port_sizes[0]);
+    Yosys::SigSpec sig_b = input_port_sig(module, node, node->input_port_sizes[0], node->num_input_pins - node->input_port_sizes[0]);
 
-    for (int i = 0; i < node->num_output_pins; i++) {
-        std::string p, q;
-        p = Yosys::stringf("%s[%d]", hard_multipliers->outputs->name, i);
-        q = node->output_pins[i]->name;
-
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(p);
-        if (wp.first.empty())
-            cell->setPort(Yosys::RTLIL::escape_id(p), to_wire(q, module));
-        else
-            cell_wideports_cache[wp.first][wp.second] = to_wire(q, module);
-    }
-
-    handle_cell_wideports_cache(&cell_wideports_cache, design, module, cell);
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_multipliers->inputs->next->name), flip ? sig_b : sig_a);
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_multipliers->inputs->name), flip ? sig_a : sig_b);
+    set_cell_port(design, cell, Yosys::RTLIL::escape_id(hard_multipliers->outputs->name), output_port_sig(module, node, 0, node->num_output_pins));
 
     return;
 }
@@ -842,6 +1552,8 @@ void init_split_multiplier(nnode_t *node, nnode_t *ptr, int offa, int a, int off
     ptr->related_ast_node = node->related_ast_node;
     ptr->traverse_visited = node->traverse_visited;
     ptr->node_data = NULL;
+    ptr->split_group = node->split_group;
+    ptr->split_fragments = node->split_fragments;
 
     /* Set new port sizes and parameters */
     ptr->num_input_port_sizes = 2;
@@ -855,6 +1567,7 @@ void init_split_multiplier(nnode_t *node, nnode_t *ptr, int offa, int a, int off
     /* Set the number of pins and re-locate previous pin entries */
     ptr->num_input_pins = a + b;
     ptr->input_pins = (npin_t **)vtr::malloc(sizeof(void *) * (a + b));
+    ptr->input_pins_capacity = a + b;
     for (i = 0; i < a; i++) {
         if (node_a)
             add_input_pin_to_node(ptr, copy_input_npin(node_a->input_pins[i]), i);
@@ -872,6 +1585,7 @@ void init_split_multiplier(nnode_t *node, nnode_t *ptr, int offa, int a, int off
     /* Prep output pins for connecting to cascaded multipliers */
     ptr->num_output_pins = a + b;
     ptr->output_pins = (npin_t **)vtr::malloc(sizeof(void *) * (a + b));
+    ptr->output_pins_capacity = a + b;
     for (i = 0; i < a + b; i++)
         ptr->output_pins[i] = NULL;
 
@@ -909,12 +1623,14 @@ void init_multiplier_adder(nnode_t *node, nnode_t *parent, int a, int b)
     /* Set the number of input pins and clear pin entries */
     node->num_input_pins = a + b;
     node->input_pins = (npin_t **)vtr::malloc(sizeof(void *) * (a + b));
+    node->input_pins_capacity = a + b;
     for (i = 0; i < a + b; i++)
         node->input_pins[i] = NULL;
 
     /* Set the number of output pins and clear pin entries */
     node->num_output_pins = size;
     node->output_pins = (npin_t **)vtr::malloc(sizeof(void *) * size);
+    node->output_pins_capacity = size;
     for (i = 0; i < size; i++)
         node->output_pins[i] = NULL;
 
@@ -1319,6 +2035,12 @@ void iterate_multipliers(netlist_t *netlist)
 
         oassert(node->type == MULTIPLY);
 
+        /* record the hard multipliers the node takes before splitting it, the pieces inherit it */
+        if (node->split_group < 0) {
+            node->split_group = node->unique_id;
+            node->split_fragments = hard_multiplier_fragments(node);
+        }
+
         mula = node->input_port_sizes[0];
         mulb = node->input_port_sizes[1];
         int mult_size = std::max<int>(mula, mulb);
@@ -1647,136 +2369,70 @@ mult_port_stat_e is_constant_multipication(nnode_t *node, netlist_t *netlist)
  * (function: check_constant_multipication )
  *
  * @brief checking for constant multipication. If one port is constant,
- * the multipication node will explode into multiple adders
+ * the multipication node is queued to be exploded into shift-and-add
+ * logic once resolve is done (see implement_constant_multipliers)
  *
  * @param node pointing to the mul node
  * @param traverse_mark_number unique traversal mark for blif elaboration pass
  * @param netlist pointer to the current netlist file
+ *
+ * @return whether the node was queued, it is not a multiplier to map for now
  *-----------------------------------------------------------------------------------------*/
 bool check_constant_multipication(nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist)
 {
     oassert(node->traverse_visited == traverse_mark_number);
 
-    /* to calculate return value */
-    mult_port_stat_e is_const;
-
     /* checking multipication ports to specify whether it is constant or not */
-    if ((is_const = is_constant_multipication(node, netlist)) != mult_port_stat_e::NOT_CONSTANT) {
-        /* performaing optimization on the constant multiplication ports */
-        node = perform_const_mult_optimization(is_const, node, traverse_mark_number, netlist);
-        /* implementation of constant multipication which is actually cascading adders */
-        signal_list_t *output_signals = implement_constant_multipication(node, is_const, static_cast<short>(traverse_mark_number), netlist);
+    mult_port_stat_e is_const = is_constant_multipication(node, netlist);
+    if (is_const == mult_port_stat_e::NOT_CONSTANT || node->num_output_pins == 0)
+        return false;
 
-        /* connecting the output pins */
-        connect_constant_mult_outputs(node, output_signals);
-    }
+    const_mult_list = insert_in_vptr_list(const_mult_list, node);
 
-    return (is_const != mult_port_stat_e::NOT_CONSTANT);
+    return true;
 }
 
 /**
  *-------------------------------------------------------------------------------------------
- * (function: perform_const_mult_optimization )
+ * (function: implement_constant_multipliers )
  *
- * @brief checking for constant multipication constant port size.
- * if possible the extra unneccessary pins of constant port will
- * be reduced
+ * @brief rewrites the constant multiplications queued by resolve into
+ * shift-and-add networks, before the multipliers are split and mapped.
+ * They are grouped by variable operand and signedness, and each group
+ * shares one adder graph (see implement_constant_multiplier_group).
  *
- * @param node pointing to the mul node
- * @param traverse_mark_number unique traversal mark for blif elaboration pass
  * @param netlist pointer to the current netlist file
  *-----------------------------------------------------------------------------------------*/
-static nnode_t *perform_const_mult_optimization(mult_port_stat_e mult_port_stat, nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist)
+void implement_constant_multipliers(netlist_t *netlist)
 {
-    oassert(node->traverse_visited == traverse_mark_number);
-
-    int i;
-    /* constatnt and variable port of the given multipication */
-    signal_list_t *const_port = init_signal_list();
-    signal_list_t *var_port = init_signal_list();
-    operation_list const_signedness = UNSIGNED;
-    operation_list var_signedness = UNSIGNED;
-
-    /* initialize const and var port signals */
-    if (mult_port_stat == mult_port_stat_e::MULTIPICAND_CONSTANT) {
-        /* adding var port pins to signal list */
-        for (i = 0; i < node->input_port_sizes[0]; i++) {
-            add_pin_to_signal_list(var_port, node->input_pins[i]);
-        }
-        var_signedness = node->attributes->port_a_signed;
-        /* adding const port pins to signal list */
-        for (i = node->input_port_sizes[0]; i < node->num_input_pins; i++) {
-            add_pin_to_signal_list(const_port, node->input_pins[i]);
-        }
-        const_signedness = node->attributes->port_b_signed;
-    } else if (mult_port_stat == mult_port_stat_e::MULTIPLIER_CONSTANT) {
-        /* adding var port pins to signal list */
-        for (i = 0; i < node->input_port_sizes[0]; i++) {
-            add_pin_to_signal_list(const_port, node->input_pins[i]);
-        }
-        const_signedness = node->attributes->port_a_signed;
-        /* adding const port pins to signal list */
-        for (i = node->input_port_sizes[0]; i < node->num_input_pins; i++) {
-            add_pin_to_signal_list(var_port, node->input_pins[i]);
-        }
-        var_signedness = node->attributes->port_b_signed;
+    /* groups in the order their first multiplier was queued */
+    std::vector<std::vector<nnode_t *>> groups;
+    std::map<std::pair<const_bits_t, bool>, size_t> group_index;
+
+    std::vector<nnode_t *> queued;
+    while (const_mult_list != NULL) {
+        queued.push_back((nnode_t *)const_mult_list->data_vptr);
+        const_mult_list = delete_in_vptr_list(const_mult_list);
     }
+    std::reverse(queued.begin(), queued.end());
 
-    int idx = -1;
-    signal_list_t *new_const_port = init_signal_list();
-    /* iterating over const port to determine useless ports */
-    for (i = const_port->count; i > 0; i--) {
-        npin_t *pin = const_port->pins[i - 1];
-        /* starting from the end and prune pins connected to GND */
-        if (!strcmp(pin->net->name, netlist->one_net->name)) {
-            idx = i;
-            break;
-        } else {
-            /* detach from the old mult node and free pin */
-            delete_npin(pin);
+    for (nnode_t *node : queued) {
+        mult_port_stat_e is_const = is_constant_multipication(node, netlist);
+        bool is_signed = (node->attributes->port_a_signed == SIGNED && node->attributes->port_b_signed == SIGNED);
+        int variable_operand_width = node->input_port_sizes[(is_const == mult_port_stat_e::MULTIPICAND_CONSTANT) ? 0 : 1];
+
+        auto key = std::make_pair(variable_operand_bits(node, is_const, variable_operand_width, netlist), is_signed);
+        if (!group_index.count(key)) {
+            group_index[key] = groups.size();
+            groups.push_back(std::vector<nnode_t *>());
         }
-    }
-    /* initializing new const port */
-    for (i = 0; i < idx; i++) {
-        npin_t *pin = const_port->pins[i];
-        add_pin_to_signal_list(new_const_port, pin);
-    }
-
-    signal_list_t *first_port = (mult_port_stat == mult_port_stat_e::MULTIPLIER_CONSTANT) ? new_const_port : var_port;
-    signal_list_t *second_port = (mult_port_stat == mult_port_stat_e::MULTIPLIER_CONSTANT) ? var_port : new_const_port;
-    /* creating new mult node */
-    int offset = 0;
-    nnode_t *new_node = make_2port_gate(node->type, first_port->count, second_port->count, node->num_output_pins, node, traverse_mark_number);
-    /* copy attributes */
-    if (mult_port_stat == mult_port_stat_e::MULTIPLIER_CONSTANT) {
-        new_node->attributes->port_a_signed = const_signedness;
-        new_node->attributes->port_b_signed = var_signedness;
-    } else {
-        new_node->attributes->port_a_signed = var_signedness;
-        new_node->attributes->port_b_signed = const_signedness;
-    }
-    /* adding first port */
-    for (i = 0; i < first_port->count; i++) {
-        remap_pin_to_new_node(first_port->pins[i], new_node, offset + i);
-    }
-    offset += first_port->count;
-    /* adding second port */
-    for (i = 0; i < second_port->count; i++) {
-        remap_pin_to_new_node(second_port->pins[i], new_node, offset + i);
-    }
-    /* remap output ports */
-    for (i = 0; i < node->num_output_pins; i++) {
-        remap_pin_to_new_node(node->output_pins[i], new_node, i);
+        groups[group_index[key]].push_back(node);
     }
 
-    // CLEAN UP
-    free_signal_list(const_port);
-    free_signal_list(var_port);
-    free_signal_list(new_const_port);
-    free_nnode(node);
-    node = NULL;
+    for (std::vector<nnode_t *> &group : groups)
+        implement_constant_multiplier_group(group, netlist);
 
-    return (new_node);
+    const_products.clear();
 }
 
 /**
@@ -1807,7 +2463,8 @@ void check_multiplier_port_size(nnode_t *node)
         node->output_port_sizes[0] = limit;
         // Keep record of old output pins pointer for cleaning up later
         npin_t **old_output_pins = node->output_pins;
-        node->output_pins = (npin_t **)calloc(node->num_output_pins, sizeof(npin_t *));
+        node->output_pins = (npin_t **)vtr::calloc(node->num_output_pins, sizeof(npin_t *));
+        node->output_pins_capacity = node->num_output_pins;
 
         // Move output pins to new array and adding pad pins in extra spots
         for (int i = 0; i < node->num_output_pins; i++) {
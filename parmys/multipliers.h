@@ -50,6 +50,11 @@ extern void report_mult_distribution();
 extern void declare_hard_multiplier(nnode_t *node);
 extern void instantiate_hard_multiplier(nnode_t *node, short mark, netlist_t *netlist);
 extern void instantiate_simple_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist);
+extern void instantiate_tree_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist);
+extern void instantiate_booth_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist);
+extern void instantiate_soft_multiplier(nnode_t *node, short mark, netlist_t *netlist);
+extern void estimate_soft_multiplier_cost(nnode_t *node, long *luts, long *depth);
+extern int hard_multiplier_fragments(nnode_t *node);
 extern void connect_constant_mult_outputs(nnode_t *node, signal_list_t *output_signal_list);
 extern void find_hard_multipliers();
 extern void add_the_blackbox_for_mults_yosys(Yosys::Design *design);
@@ -57,6 +62,7 @@ extern void define_mult_function_yosys(nnode_t *node, Yosys::Module *module, Yos
 extern void split_multiplier(nnode_t *node, int a0, int b0, int a1, int b1, netlist_t *netlist);
 extern void iterate_multipliers(netlist_t *netlist);
 extern bool check_constant_multipication(nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist);
+extern void implement_constant_multipliers(netlist_t *netlist);
 extern void check_multiplier_port_size(nnode_t *node);
 extern void clean_multipliers();
 extern void free_multipliers();
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "netlist_traversal.h"
 #include "netlist_utils.h"
 #include "odin_util.h"
 // #include "ast_util.h"
@@ -61,6 +62,7 @@ void check_netlist(netlist_t *netlist)
 }
 
 void depth_traverse_check_combinational_loop(nnode_t *node, short start, STRING_CACHE *in_path);
+static bool visit_until_next_ff_or_output(nnode_t *node, nnode_t *calling_node, uintptr_t traverse_mark_number, int seq_level, netlist_t *netlist);
 
 /*---------------------------------------------------------------------------------------------
  * (function: depth_first_traversal_check_if_forward_leveled()
@@ -145,10 +147,21 @@ void sequential_levelized_dfs(short marker_value, netlist_t *netlist)
 void depth_first_traverse_until_next_ff_or_output(nnode_t *node, nnode_t *calling_node, uintptr_t traverse_mark_number, int seq_level,
                                                   netlist_t *netlist)
 {
-    int i, j;
-    nnode_t *next_node;
-    nnet_t *next_net;
+    walk_fanout(
+      node, seq_level,
+      [&](nnode_t *visited, nnode_t *parent, int &level) {
+          return visit_until_next_ff_or_output(visited, (parent) ? parent : calling_node, traverse_mark_number, level, netlist);
+      },
+      [](nnode_t *, int) {});
+}
 
+/*---------------------------------------------------------------------------------------------
+ * (function: visit_until_next_ff_or_output)
+ * 	Records one node of the sequential level walk.
+ * 	Returns true if the walk should continue into its fanout.
+ *-------------------------------------------------------------------------------------------*/
+static bool visit_until_next_ff_or_output(nnode_t *node, nnode_t *calling_node, uintptr_t traverse_mark_number, int seq_level, netlist_t *netlist)
+{
     /* first, check if the clalling node should be recorderd */
     if ((calling_node != NULL) && ((node->type == FF_NODE) || (node->type == OUTPUT_NODE))) {
         /* IF - the this node is the end of a sequential level then the node before needs to be stored */
@@ -171,10 +184,10 @@ void depth_first_traverse_until_next_ff_or_output(nnode_t *node, nnode_t *callin
 
     if (node->traverse_visited == traverse_mark_number) {
         /* if already visited then nothing to do */
-        return;
+        return false;
     } else if (node->type == CLOCK_NODE) {
         /* since this is a node that touches all flip flops, don't analyze for sequential level */
-        return;
+        return false;
     } else if (node->type == FF_NODE) {
         /* ELSE IF - this is a ff_node, so add it to the list for the next sequential level */
         /* mark as traversed */
@@ -187,29 +200,14 @@ void depth_first_traverse_until_next_ff_or_output(nnode_t *node, nnode_t *callin
           netlist->sequential_level_nodes[seq_level + 1], sizeof(nnode_t *) * netlist->num_at_sequential_level[seq_level + 1]);
         netlist->sequential_level_nodes[seq_level + 1][netlist->num_at_sequential_level[seq_level + 1] - 1] = node;
 
-        return;
+        return false;
     } else {
         /* ELSE - this is a node so depth visit it */
 
         node->traverse_visited = traverse_mark_number;
         node->sequential_level = seq_level;
 
-        for (i = 0; i < node->num_output_pins; i++) {
-            if (node->output_pins[i]->net == NULL)
-                continue;
-
-            next_net = node->output_pins[i]->net;
-            for (j = 0; j < next_net->num_fanout_pins; j++) {
-                if (next_net->fanout_pins[j] == NULL)
-                    continue;
-
-                next_node = next_net->fanout_pins[j]->node;
-                if (next_node == NULL)
-                    continue;
-
-                depth_first_traverse_until_next_ff_or_output(next_node, node, traverse_mark_number, seq_level, netlist);
-            }
-        }
+        return true;
     }
 }
 
@@ -238,40 +236,23 @@ void depth_first_traversal_check_if_forward_leveled(short marker_value, netlist_
  *-------------------------------------------------------------------------------------------*/
 void depth_first_traverse_check_if_forward_leveled(nnode_t *node, uintptr_t traverse_mark_number)
 {
-    int i, j;
-    nnode_t *next_node;
-    nnet_t *next_net;
-
-    if (node->traverse_visited == traverse_mark_number) {
-        return;
-    } else {
-        /* ELSE - this is a new node so depth visit it */
-
-        node->traverse_visited = traverse_mark_number;
-
-        for (i = 0; i < node->num_output_pins; i++) {
-            if (node->output_pins[i]->net == NULL)
-                continue;
-
-            next_net = node->output_pins[i]->net;
-            for (j = 0; j < next_net->num_fanout_pins; j++) {
-                if (next_net->fanout_pins[j] == NULL)
-                    continue;
-
-                next_node = next_net->fanout_pins[j]->node;
-                if (next_node == NULL)
-                    continue;
-
-                if ((next_node->forward_level == -1) && (next_node->type != FF_NODE)) {
-                    graphVizOutputCombinationalNet(configuration.debug_output_path, "combo_loop", COMBO_LOOP_ERROR,
-                                                   /*next_node);*/ find_node_at_top_of_combo_loop(next_node));
-                    oassert(false);
-                }
-
-                depth_first_traverse_check_if_forward_leveled(next_node, traverse_mark_number);
-            }
-        }
-    }
+    walk_fanout(
+      node, 0,
+      [traverse_mark_number](nnode_t *next_node, nnode_t *parent, int &) {
+          if (parent && (next_node->forward_level == -1) && (next_node->type != FF_NODE)) {
+              graphVizOutputCombinationalNet(configuration.debug_output_path, "combo_loop", COMBO_LOOP_ERROR,
+                                             /*next_node);*/ find_node_at_top_of_combo_loop(next_node));
+              oassert(false);
+          }
+
+          if (next_node->traverse_visited == traverse_mark_number)
+              return false;
+
+          /* this is a new node so depth visit it */
+          next_node->traverse_visited = traverse_mark_number;
+          return true;
+      },
+      [](nnode_t *, int) {});
 }
 /*---------------------------------------------------------------------------------------------
  * (function: levelize_forwards)
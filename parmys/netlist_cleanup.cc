@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "netlist_traversal.h"
 #include "netlist_utils.h"
 #include "odin_ii.h"
 #include "vtr_memory.h"
@@ -76,18 +77,16 @@ node_list_t *insert_node_list(node_list_t *node_list, nnode_t *node)
 /* Traverse the netlist backwards, moving from outputs to inputs */
 void traverse_backward(nnode_t *node)
 {
-    if (node->node_data == VISITED_BACKWARD)
-        return;                         // Already visited
-    node->node_data = VISITED_BACKWARD; // Mark as visited
-    int i;
-    for (i = 0; i < node->num_input_pins; i++) {
-        // ensure this net has a driver (i.e. skip undriven outputs)
-        for (int j = 0; j < node->input_pins[i]->net->num_driver_pins; j++) {
-            if (node->input_pins[i]->net->driver_pins[j]->node)
-                // Visit the drivers of this node
-                traverse_backward(node->input_pins[i]->net->driver_pins[j]->node);
-        }
-    }
+    // Visit the drivers of every node (undriven nets have no driver pins)
+    walk_fanin(
+      node, 0,
+      [](nnode_t *visited, nnode_t *, int &) {
+          if (visited->node_data == VISITED_BACKWARD)
+              return false;                      // Already visited
+          visited->node_data = VISITED_BACKWARD; // Mark as visited
+          return true;
+      },
+      [](nnode_t *, int) {});
 }
 
 /* Traverse the netlist forward, moving from inputs to outputs.
@@ -101,55 +100,47 @@ void traverse_forward(nnode_t *node, int toplevel, int remove_me)
 {
     if (node == NULL)
         return; // Shouldn't happen, but check just in case
-    if (node->node_data == VISITED_FORWARD)
-        return; // Already visited, shouldn't happen anyway
-
-    /* We want to remove this node if either its parent was removed,
-     * or if it was not visited on the backwards sweep */
-    remove_me = remove_me || ((node->node_data != VISITED_BACKWARD) && (toplevel == false));
 
-    /* Mark this node as visited */
-    node->node_data = VISITED_FORWARD;
-
-    if (remove_me) {
-        /* Add this node to the list of nodes to remove */
-        removal_list_next = insert_node_list(removal_list_next, node);
-        count_node_type(node);
-    }
-
-    if (node->type == ADD || node->type == MINUS) {
-        // check if adders/subtractors are starting using a global gnd/vcc node or a pad node
-        auto ADDER_START_NODE = PAD_NODE;
-        if (configuration.adder_cin_global) {
-            if (node->type == ADD)
-                ADDER_START_NODE = GND_NODE;
-            else
-                ADDER_START_NODE = VCC_NODE;
-        }
-        oassert(node->input_pins[node->num_input_pins - 1]->net->num_driver_pins == 1);
-        /* Check if we've found the head of an adder or subtractor chain */
-        if (node->input_pins[node->num_input_pins - 1]->net->driver_pins[0]->node->type == ADDER_START_NODE) {
-            addsub_list_next = insert_node_list(addsub_list_next, node);
-        }
-    }
-
-    /* Iterate through every fanout node */
-    int i, j;
-    for (i = 0; i < node->num_output_pins; i++) {
-        if (node->output_pins[i] && node->output_pins[i]->net) {
-            for (j = 0; j < node->output_pins[i]->net->num_fanout_pins; j++) {
-                if (node->output_pins[i]->net->fanout_pins[j]) {
-                    nnode_t *child = node->output_pins[i]->net->fanout_pins[j]->node;
-                    if (child) {
-                        /* If this child hasn't already been visited, visit it now */
-                        if (child->node_data != VISITED_FORWARD) {
-                            traverse_forward(child, false, remove_me);
-                        }
-                    }
-                }
-            }
-        }
-    }
+    /* the removal decision of a node is handed down to its fanout */
+    walk_fanout(
+      node, remove_me,
+      [toplevel](nnode_t *visited, nnode_t *parent, int &remove_visited) {
+          if (visited->node_data == VISITED_FORWARD)
+              return false; // Already visited
+
+          /* We want to remove this node if either its parent was removed,
+           * or if it was not visited on the backwards sweep */
+          bool is_toplevel = (parent == NULL) && toplevel;
+          remove_visited = remove_visited || ((visited->node_data != VISITED_BACKWARD) && (is_toplevel == false));
+
+          /* Mark this node as visited */
+          visited->node_data = VISITED_FORWARD;
+
+          if (remove_visited) {
+              /* Add this node to the list of nodes to remove */
+              removal_list_next = insert_node_list(removal_list_next, visited);
+              count_node_type(visited);
+          }
+
+          if (visited->type == ADD || visited->type == MINUS) {
+              // check if adders/subtractors are starting using a global gnd/vcc node or a pad node
+              auto ADDER_START_NODE = PAD_NODE;
+              if (configuration.adder_cin_global) {
+                  if (visited->type == ADD)
+                      ADDER_START_NODE = GND_NODE;
+                  else
+                      ADDER_START_NODE = VCC_NODE;
+              }
+              oassert(visited->input_pins[visited->num_input_pins - 1]->net->num_driver_pins == 1);
+              /* Check if we've found the head of an adder or subtractor chain */
+              if (visited->input_pins[visited->num_input_pins - 1]->net->driver_pins[0]->node->type == ADDER_START_NODE) {
+                  addsub_list_next = insert_node_list(addsub_list_next, visited);
+              }
+          }
+
+          return true;
+      },
+      [](nnode_t *, int) {});
 }
 
 /* Start at each of the top level output nodes and traverse backwards to the inputs
@@ -0,0 +1,162 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @file This file provides the depth first walks over the netlist
+ * used by the netlist passes. They keep their own stack of frames
+ * on the heap, so the native stack usage does not depend on the
+ * depth of the netlist (long carry chains, adder trees).
+ *
+ * Both walks visit nodes in exactly the order of the recursive
+ * versions they replace: the nets and the pin counts are re-read
+ * at every step, so passes that rewire the netlist while walking
+ * it (e.g. partial mapping) see the same netlist they used to.
+ */
+#ifndef NETLIST_TRAVERSAL_H
+#define NETLIST_TRAVERSAL_H
+
+#include <vector>
+
+#include "odin_types.h"
+
+/* one level of the walk, what a recursive call kept in its locals */
+struct traversal_frame_t {
+    nnode_t *node;
+    nnet_t *net; // net of the current pin, cached like the recursive walks did
+    int pin;
+    int neighbour;
+    int state;
+};
+
+/* fanout nodes, reached through the output pins */
+struct fanout_edges_t {
+    static int num_pins(nnode_t *node) { return node->num_output_pins; }
+    static npin_t *pin(nnode_t *node, int idx) { return node->output_pins[idx]; }
+    static int num_neighbours(nnet_t *net) { return net->fanout_pins ? net->num_fanout_pins : 0; }
+    static npin_t *neighbour(nnet_t *net, int idx) { return net->fanout_pins[idx]; }
+};
+
+/* driver nodes, reached through the input pins */
+struct fanin_edges_t {
+    static int num_pins(nnode_t *node) { return node->num_input_pins; }
+    static npin_t *pin(nnode_t *node, int idx) { return node->input_pins[idx]; }
+    static int num_neighbours(nnet_t *net) { return net->driver_pins ? net->num_driver_pins : 0; }
+    static npin_t *neighbour(nnet_t *net, int idx) { return net->driver_pins[idx]; }
+};
+
+/**
+ * (function: walk_netlist)
+ *
+ * @brief depth first walk from root over the edges selected by Edges.
+ *
+ * @param root the node to start from
+ * @param root_state the state handed to enter for the root
+ * @param enter called every time an edge reaches a node (parent is
+ * NULL for the root). state holds the parent's state on entry, the
+ * value left in it is handed to the node's own neighbours. Returns
+ * true to walk into the node; marking it as visited is up to the
+ * caller, exactly as in the recursive versions.
+ * @param leave called after all neighbours of an entered node were
+ * walked (post-order), it may free or rewire the node.
+ */
+template <typename Edges, typename Enter, typename Leave> void walk_netlist(nnode_t *root, int root_state, Enter enter, Leave leave)
+{
+    if (root == NULL)
+        return;
+
+    int state = root_state;
+    if (!enter(root, (nnode_t *)NULL, state))
+        return;
+
+    std::vector<traversal_frame_t> stack;
+    stack.push_back({root, NULL, -1, 0, state});
+
+    while (!stack.empty()) {
+        traversal_frame_t &frame = stack.back();
+        nnode_t *next_node = NULL;
+
+        while (next_node == NULL) {
+            if (frame.net == NULL || frame.neighbour >= Edges::num_neighbours(frame.net)) {
+                /* done with this pin, move on to the next one */
+                frame.pin++;
+                if (frame.pin >= Edges::num_pins(frame.node))
+                    break;
+
+                npin_t *pin = Edges::pin(frame.node, frame.pin);
+                frame.net = (pin) ? pin->net : NULL;
+                frame.neighbour = 0;
+                continue;
+            }
+
+            npin_t *next_pin = Edges::neighbour(frame.net, frame.neighbour++);
+            if (next_pin)
+                next_node = next_pin->node;
+        }
+
+        if (next_node == NULL) {
+            nnode_t *node = frame.node;
+            int node_state = frame.state;
+            stack.pop_back();
+            leave(node, node_state);
+            continue;
+        }
+
+        /* frame is not used past this point, push_back may move it */
+        nnode_t *parent = frame.node;
+        state = frame.state;
+        if (enter(next_node, parent, state))
+            stack.push_back({next_node, NULL, -1, 0, state});
+    }
+}
+
+/* walk towards the outputs */
+template <typename Enter, typename Leave> void walk_fanout(nnode_t *root, int root_state, Enter enter, Leave leave)
+{
+    walk_netlist<fanout_edges_t>(root, root_state, enter, leave);
+}
+
+/* walk towards the inputs */
+template <typename Enter, typename Leave> void walk_fanin(nnode_t *root, int root_state, Enter enter, Leave leave)
+{
+    walk_netlist<fanin_edges_t>(root, root_state, enter, leave);
+}
+
+/**
+ * (function: walk_fanout_post_order)
+ *
+ * @brief the common case: enter every node not marked with
+ * traverse_mark_number once, mark it, and call leave(node) after
+ * all of its fanout has been walked.
+ */
+template <typename Leave> void walk_fanout_post_order(nnode_t *root, uintptr_t traverse_mark_number, Leave leave)
+{
+    walk_fanout(
+      root, 0,
+      [traverse_mark_number](nnode_t *node, nnode_t *, int &) {
+          if (node->traverse_visited == traverse_mark_number)
+              return false;
+          node->traverse_visited = traverse_mark_number;
+          return true;
+      },
+      [&leave](nnode_t *node, int) { leave(node); });
+}
+
+#endif
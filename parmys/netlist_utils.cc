@@ -28,18 +28,48 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "ObjectPool.hpp"
 #include "netlist_utils.h"
 #include "node_creation_library.h"
 #include "odin_util.h"
 #include "vtr_memory.h"
 #include "vtr_util.h"
 
+/**
+ * the arena of the netlist under construction. allocate_netlist
+ * activates it and free_netlist releases it, so every node, pin
+ * and net created in between is carved out of its slab pools.
+ * Structures created while no netlist is alive fall back to the heap,
+ * and are given back to the heap when freed, whichever arena is active.
+ */
+static netlist_arena_t *active_arena = NULL;
+
+/*---------------------------------------------------------------------------------------------
+ * (function: release_npin_struct)
+ * 	returns the memory of a pin structure to where it came from
+ *-------------------------------------------------------------------------------------------*/
+static npin_t *release_npin_struct(npin_t *to_free)
+{
+    if (active_arena && active_arena->pins.owns(to_free))
+        active_arena->pins.deallocate(to_free);
+    else
+        vtr::free(to_free);
+
+    return NULL;
+}
+
 /*---------------------------------------------------------------------------------------------
  * (function: allocate_nnode)
  *-------------------------------------------------------------------------------------------*/
 nnode_t *allocate_nnode(loc_t loc)
 {
-    nnode_t *new_node = (nnode_t *)my_malloc_struct(sizeof(nnode_t));
+    nnode_t *new_node;
+    if (active_arena) {
+        new_node = active_arena->nodes.allocate();
+        new_node->unique_id = next_unique_id();
+    } else {
+        new_node = (nnode_t *)my_malloc_struct(sizeof(nnode_t));
+    }
 
     new_node->loc = loc;
     new_node->name = NULL;
@@ -50,8 +80,10 @@ nnode_t *allocate_nnode(loc_t loc)
 
     new_node->input_pins = NULL;
     new_node->num_input_pins = 0;
+    new_node->input_pins_capacity = 0;
     new_node->output_pins = NULL;
     new_node->num_output_pins = 0;
+    new_node->output_pins_capacity = 0;
 
     new_node->input_port_sizes = NULL;
     new_node->num_input_port_sizes = 0;
@@ -66,6 +98,9 @@ nnode_t *allocate_nnode(loc_t loc)
     new_node->sequential_level = -1;
     new_node->sequential_terminator = false;
 
+    new_node->split_group = -1;
+    new_node->split_fragments = 0;
+
     //    new_node->in_queue = false;
 
     //    new_node->undriven_pins = 0;
@@ -93,7 +128,7 @@ nnode_t *free_nnode(nnode_t *to_free)
                 vtr::free(to_free->input_pins[i]->name);
                 to_free->input_pins[i]->name = NULL;
             }
-            to_free->input_pins[i] = (npin_t *)vtr::free(to_free->input_pins[i]);
+            to_free->input_pins[i] = release_npin_struct(to_free->input_pins[i]);
         }
 
         to_free->input_pins = (npin_t **)vtr::free(to_free->input_pins);
@@ -103,7 +138,7 @@ nnode_t *free_nnode(nnode_t *to_free)
                 vtr::free(to_free->output_pins[i]->name);
                 to_free->output_pins[i]->name = NULL;
             }
-            to_free->output_pins[i] = (npin_t *)vtr::free(to_free->output_pins[i]);
+            to_free->output_pins[i] = release_npin_struct(to_free->output_pins[i]);
         }
 
         to_free->output_pins = (npin_t **)vtr::free(to_free->output_pins);
@@ -120,6 +155,10 @@ nnode_t *free_nnode(nnode_t *to_free)
         }
 
         /* now free the node */
+        if (active_arena && active_arena->nodes.owns(to_free)) {
+            active_arena->nodes.deallocate(to_free);
+            return NULL;
+        }
     }
     return (nnode_t *)vtr::free(to_free);
 }
@@ -137,7 +176,7 @@ void allocate_more_input_pins(nnode_t *node, int width)
         return;
     }
 
-    node->input_pins = (npin_t **)vtr::realloc(node->input_pins, sizeof(npin_t *) * (node->num_input_pins + width));
+    node->input_pins = grow_array(node->input_pins, node->input_pins_capacity, node->num_input_pins + width);
     for (i = 0; i < width; i++) {
         node->input_pins[node->num_input_pins + i] = NULL;
     }
@@ -157,7 +196,7 @@ void allocate_more_output_pins(nnode_t *node, int width)
         return;
     }
 
-    node->output_pins = (npin_t **)vtr::realloc(node->output_pins, sizeof(npin_t *) * (node->num_output_pins + width));
+    node->output_pins = grow_array(node->output_pins, node->output_pins_capacity, node->num_output_pins + width);
     for (i = 0; i < width; i++) {
         node->output_pins[node->num_output_pins + i] = NULL;
     }
@@ -191,7 +230,12 @@ npin_t *allocate_npin()
 {
     npin_t *new_pin;
 
-    new_pin = (npin_t *)my_malloc_struct(sizeof(npin_t));
+    if (active_arena) {
+        new_pin = active_arena->pins.allocate();
+        new_pin->unique_id = next_unique_id();
+    } else {
+        new_pin = (npin_t *)my_malloc_struct(sizeof(npin_t));
+    }
 
     new_pin->name = NULL;
     new_pin->type = NO_ID;
@@ -229,7 +273,7 @@ npin_t *free_npin(npin_t *to_free)
 
         /* now free the pin */
     }
-    return (npin_t *)vtr::free(to_free);
+    return release_npin_struct(to_free);
 }
 
 /*-------------------------------------------------------------------------
@@ -278,23 +322,44 @@ npin_t *copy_input_npin(npin_t *copy_pin)
     return new_pin;
 }
 
+/*-------------------------------------------------------------------------
+ * (function: make_fanout_pin)
+ * 	Makes a new input pin reading the given net
+ *-----------------------------------------------------------------------*/
+npin_t *make_fanout_pin(nnet_t *net)
+{
+    npin_t *pin = allocate_npin();
+    add_fanout_pin_to_net(net, pin);
+    return pin;
+}
+
 /*---------------------------------------------------------------------------------------------
  * (function: allocate_nnet)
  *-------------------------------------------------------------------------------------------*/
 nnet_t *allocate_nnet()
 {
-    nnet_t *new_net = (nnet_t *)my_malloc_struct(sizeof(nnet_t));
+    nnet_t *new_net;
+    if (active_arena) {
+        new_net = active_arena->nets.allocate();
+        new_net->unique_id = next_unique_id();
+    } else {
+        new_net = (nnet_t *)my_malloc_struct(sizeof(nnet_t));
+    }
 
     new_net->name = NULL;
     new_net->driver_pins = NULL;
     new_net->num_driver_pins = 0;
+    new_net->driver_pins_capacity = 0;
     new_net->fanout_pins = NULL;
     new_net->num_fanout_pins = 0;
+    new_net->fanout_pins_capacity = 0;
     new_net->combined = false;
 
     new_net->net_data = NULL;
     new_net->unique_net_data_id = -1;
 
+    new_net->has_yosys_bit = false;
+
     return new_net;
 }
 
@@ -313,6 +378,10 @@ nnet_t *free_nnet(nnet_t *to_free)
             vtr::free(to_free->driver_pins);
 
         /* now free the net */
+        if (active_arena && active_arena->nets.owns(to_free)) {
+            active_arena->nets.deallocate(to_free);
+            return NULL;
+        }
     }
     return (nnet_t *)vtr::free(to_free);
 }
@@ -382,7 +451,7 @@ void add_fanout_pin_to_net(nnet_t *net, npin_t *pin)
     oassert(pin != NULL);
     oassert(pin->type != OUTPUT);
     /* assumes the pin spots have been allocated and the pin */
-    net->fanout_pins = (npin_t **)vtr::realloc(net->fanout_pins, sizeof(npin_t *) * (net->num_fanout_pins + 1));
+    net->fanout_pins = grow_array(net->fanout_pins, net->fanout_pins_capacity, net->num_fanout_pins + 1);
     net->fanout_pins[net->num_fanout_pins] = pin;
     net->num_fanout_pins++;
     /* record the node and pin spot in the pin */
@@ -417,7 +486,7 @@ void add_driver_pin_to_net(nnet_t *net, npin_t *pin)
     oassert(pin->type != INPUT);
     /* assumes the pin spots have been allocated and the pin */
     net->num_driver_pins++;
-    net->driver_pins = (npin_t **)vtr::realloc(net->driver_pins, net->num_driver_pins * sizeof(npin_t *));
+    net->driver_pins = grow_array(net->driver_pins, net->driver_pins_capacity, net->num_driver_pins);
     net->driver_pins[net->num_driver_pins - 1] = pin;
     /* record the node and pin spot in the pin */
     pin->net = net;
@@ -484,6 +553,7 @@ void remap_pin_to_new_net(npin_t *pin, nnet_t *new_net)
             vtr::free(pin->net->driver_pins);
         pin->net->num_driver_pins = 0;
         pin->net->driver_pins = NULL;
+        pin->net->driver_pins_capacity = 0;
         /* do the new addition */
         add_driver_pin_to_net(new_net, pin);
     }
@@ -544,6 +614,61 @@ void connect_nodes(nnode_t *out_node, int out_idx, nnode_t *in_node, int in_idx)
     }
 }
 
+/*-------------------------------------------------------------------------
+ * (function: decode_address_banks)
+ * 	One-hot decodes the width address bits of addr starting at offset into
+ * 	the select signal of every bank of a memory split in depth, gated by
+ * 	enable if given. When consume is set, the select and enable pins are
+ * 	moved from their node onto the decoder instead of being copied. With
+ * 	no select bits the single bank is selected by enable, or always, which
+ * 	is the only case that reads netlist.
+ *-----------------------------------------------------------------------*/
+std::vector<nnet_t *> decode_address_banks(signal_list_t *addr, int offset, int width, npin_t *enable, bool consume, nnode_t *node, netlist_t *netlist)
+{
+    long num_banks = shift_left_value_with_overflow_check(0x1, width, node->loc);
+    std::vector<nnet_t *> banks(num_banks, NULL);
+
+    if (width == 0) {
+        banks[0] = (enable) ? enable->net : netlist->one_net;
+        return banks;
+    }
+
+    std::vector<nnode_t *> not_gates(width);
+    for (int i = 0; i < width; i++) {
+        not_gates[i] = make_not_gate(node, node->traverse_visited);
+        if (consume)
+            remap_pin_to_new_node(addr->pins[offset + i], not_gates[i], 0);
+        else
+            add_input_pin_to_node(not_gates[i], copy_input_npin(addr->pins[offset + i]), 0);
+    }
+
+    for (long bank = 0; bank < num_banks; bank++) {
+        nnode_t *and_g = make_1port_logic_gate(LOGICAL_AND, width + ((enable) ? 1 : 0), node, node->traverse_visited);
+
+        for (int i = 0; i < width; i++) {
+            if ((bank >> i) & 0x1)
+                add_input_pin_to_node(and_g, copy_input_npin(addr->pins[offset + i]), i);
+            else
+                connect_nodes(not_gates[i], 0, and_g, i);
+        }
+
+        if (enable) {
+            if (consume && bank == 0)
+                remap_pin_to_new_node(enable, and_g, width);
+            else
+                add_input_pin_to_node(and_g, copy_input_npin(enable), width);
+        }
+
+        npin_t *out_pin = allocate_npin();
+        banks[bank] = allocate_nnet();
+        banks[bank]->name = vtr::strdup(and_g->name);
+        add_output_pin_to_node(and_g, out_pin, 0);
+        add_driver_pin_to_net(banks[bank], out_pin);
+    }
+
+    return banks;
+}
+
 /**
  * -------------------------------------------------------------------------------------------
  * (function: init_attribute_structure)
@@ -661,6 +786,7 @@ signal_list_t *init_signal_list()
     list = (signal_list_t *)vtr::malloc(sizeof(signal_list_t));
 
     list->count = 0;
+    list->capacity = 0;
     list->pins = NULL;
     list->is_memory = false;
     list->is_adder = false;
@@ -837,7 +963,7 @@ signal_list_t *prune_signal(signal_list_t *signalsvar, long signal_width, long p
  *-------------------------------------------------------------------------------------------*/
 void add_pin_to_signal_list(signal_list_t *list, npin_t *pin)
 {
-    list->pins = (npin_t **)vtr::realloc(list->pins, sizeof(npin_t *) * (list->count + 1));
+    list->pins = grow_array(list->pins, list->capacity, list->count + 1);
     list->pins[list->count] = pin;
     list->count++;
 }
@@ -1004,6 +1130,7 @@ void free_signal_list(signal_list_t *list)
     if (list) {
         vtr::free(list->pins);
         list->count = 0;
+        list->capacity = 0;
     }
     vtr::free(list);
     list = NULL;
@@ -1082,12 +1209,15 @@ netlist_t *allocate_netlist()
     new_netlist->pad_net = NULL;
     new_netlist->top_input_nodes = NULL;
     new_netlist->num_top_input_nodes = 0;
+    new_netlist->top_input_nodes_capacity = 0;
     new_netlist->top_output_nodes = NULL;
     new_netlist->num_top_output_nodes = 0;
+    new_netlist->top_output_nodes_capacity = 0;
     new_netlist->ff_nodes = NULL;
     new_netlist->num_ff_nodes = 0;
     new_netlist->internal_nodes = NULL;
     new_netlist->num_internal_nodes = 0;
+    new_netlist->internal_nodes_capacity = 0;
     new_netlist->clocks = NULL;
     new_netlist->num_clocks = 0;
 
@@ -1109,6 +1239,10 @@ netlist_t *allocate_netlist()
     new_netlist->out_pins_sc = sc_new_string_cache();
     new_netlist->nodes_sc = sc_new_string_cache();
 
+    /* from now on the netlist structures are carved out of this arena */
+    new_netlist->arena = new netlist_arena_t();
+    active_arena = new_netlist->arena;
+
     return new_netlist;
 }
 
@@ -1123,6 +1257,26 @@ void free_netlist(netlist_t *to_free)
     sc_free_string_cache(to_free->nets_sc);
     sc_free_string_cache(to_free->out_pins_sc);
     sc_free_string_cache(to_free->nodes_sc);
+
+    /* bulk release of every node, pin and net still alive in the netlist */
+    if (to_free->arena) {
+        if (active_arena == to_free->arena)
+            active_arena = NULL;
+
+        delete to_free->arena;
+        to_free->arena = NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function:  release_active_arena)
+ * 	releases the arena of a netlist free_netlist was never called on, the netlist
+ * 	structures it holds are gone with it
+ *-------------------------------------------------------------------------------------------*/
+void release_active_arena()
+{
+    delete active_arena;
+    active_arena = NULL;
 }
 
 /*
@@ -1485,6 +1639,11 @@ void equalize_ports_size(nnode_t *&node, uintptr_t traverse_mark_number, netlist
     node = new_node;
 }
 
+/*---------------------------------------------------------------------------------------------
+ * (function: remove_fanout_pins_from_net)
+ * 	Removes the fanout pin at index id and shifts the later fanouts down,
+ * 	preserving the fanout order. This is O(fanout) per removal.
+ *-------------------------------------------------------------------------------------------*/
 void remove_fanout_pins_from_net(nnet_t *net, npin_t * /*pin*/, int id)
 {
     int i;
@@ -1497,6 +1656,39 @@ void remove_fanout_pins_from_net(nnet_t *net, npin_t * /*pin*/, int id)
     net->num_fanout_pins--;
 }
 
+/*---------------------------------------------------------------------------------------------
+ * (function: remove_fanout_pin_unordered)
+ * 	Removes a fanout pin from its net in O(1) by moving the last fanout
+ * 	into its slot. Use it instead of remove_fanout_pins_from_net when the
+ * 	order of the net fanouts does not matter, e.g. detaching pins from
+ * 	high-fanout constant, clock or reset nets.
+ *-------------------------------------------------------------------------------------------*/
+void remove_fanout_pin_unordered(nnet_t *net, npin_t *pin)
+{
+    oassert(net != NULL);
+    oassert(pin != NULL);
+
+    int id = pin->pin_net_idx;
+    if (id < 0 || id >= net->num_fanout_pins || net->fanout_pins[id] != pin) {
+        /* stale index, look the pin up */
+        for (id = 0; id < net->num_fanout_pins; id++) {
+            if (net->fanout_pins[id] == pin)
+                break;
+        }
+        if (id == net->num_fanout_pins)
+            return;
+    }
+
+    int last = net->num_fanout_pins - 1;
+    if (id != last) {
+        net->fanout_pins[id] = net->fanout_pins[last];
+        if (net->fanout_pins[id] != NULL)
+            net->fanout_pins[id]->pin_net_idx = id;
+    }
+    net->fanout_pins[last] = NULL;
+    net->num_fanout_pins--;
+}
+
 void delete_npin(npin_t *pin)
 {
     if (pin->type == INPUT) {
@@ -2,6 +2,8 @@
 #define NETLIST_UTILS_H_FUNCTIONS
 
 #include "odin_types.h"
+#include "vtr_memory.h"
+#include <vector>
 
 nnode_t *allocate_nnode(loc_t loc);
 npin_t *allocate_npin();
@@ -16,6 +18,7 @@ npin_t *get_pad_pin(netlist_t *netlist);
 npin_t *get_one_pin(netlist_t *netlist);
 npin_t *copy_input_npin(npin_t *copy_pin);
 npin_t *copy_output_npin(npin_t *copy_pin);
+npin_t *make_fanout_pin(nnet_t *net);
 
 void allocate_more_input_pins(nnode_t *node, int width);
 void allocate_more_output_pins(nnode_t *node, int width);
@@ -53,9 +56,55 @@ void free_signal_list(signal_list_t *list);
 
 signal_list_t *make_output_pins_for_existing_node(nnode_t *node, int width);
 void connect_nodes(nnode_t *out_node, int out_idx, nnode_t *in_node, int in_idx);
+std::vector<nnet_t *> decode_address_banks(signal_list_t *addr, int offset, int width, npin_t *enable, bool consume, nnode_t *node, netlist_t *netlist);
 
 netlist_t *allocate_netlist();
 void free_netlist(netlist_t *to_free);
+void release_active_arena();
+
+/**
+ * (class: netlist_arena_guard)
+ *
+ * @brief keeps the netlist arena from outliving a parmys run: on
+ * every exit path of the scope, errors included, the arena of a
+ * netlist that free_netlist was not called on is released
+ */
+class netlist_arena_guard
+{
+  public:
+    netlist_arena_guard() = default;
+    ~netlist_arena_guard() { release_active_arena(); }
+
+    netlist_arena_guard(const netlist_arena_guard &) = delete;
+    netlist_arena_guard &operator=(const netlist_arena_guard &) = delete;
+};
+
+/**
+ * (function: grow_array)
+ *
+ * @brief makes room for at least needed elements in an array that
+ * was allocated with vtr::malloc/vtr::realloc. The capacity grows
+ * geometrically so a sequence of appends is amortized O(1) instead
+ * of one realloc per appended element.
+ *
+ * @param array the array to grow (may be NULL)
+ * @param capacity number of allocated slots, updated in place
+ * @param needed the number of elements the array must hold
+ *
+ * @return the (possibly moved) array
+ */
+template <typename T> T *grow_array(T *array, long &capacity, long needed)
+{
+    if (needed <= capacity)
+        return array;
+
+    long new_capacity = (capacity < 4) ? 4 : capacity;
+    while (new_capacity < needed)
+        new_capacity *= 2;
+
+    capacity = new_capacity;
+    return (T *)vtr::realloc(array, sizeof(T) * new_capacity);
+}
 
 int get_output_pin_index_from_mapping(nnode_t *node, const char *name);
 int get_output_port_index_from_mapping(nnode_t *node, const char *name);
@@ -66,6 +115,7 @@ extern void reduce_input_ports(nnode_t *&node, netlist_t *netlist);
 extern signal_list_t *reduce_signal_list(signal_list_t *signalvar, operation_list signedness, netlist_t *netlist);
 chain_information_t *allocate_chain_info();
 void remove_fanout_pins_from_net(nnet_t *net, npin_t *pin, int id);
+void remove_fanout_pin_unordered(nnet_t *net, npin_t *pin);
 
 extern void equalize_ports_size(nnode_t *&node, uintptr_t traverse_mark_number, netlist_t *netlist);
 extern void delete_npin(npin_t *pin);
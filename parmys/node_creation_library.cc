@@ -300,6 +300,9 @@ char *op_node_name(operation_list op, char *instance_prefix_name)
 {
     char *return_node_name;
 
+    /* names stay eager: node->name is read, strcmp'd, freed and reassigned directly at ~140 sites,
+     * so a lazily built name would need an accessor at every one of them. The names never reach
+     * the design (output cells take NEW_ID), so deferring them only pays off once that is done */
     /* create the unique name for this node */
     return_node_name = make_full_ref_name(instance_prefix_name, NULL, NULL, name_based_on_op(op), unique_node_name_id);
 
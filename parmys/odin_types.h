@@ -66,6 +66,7 @@
 #define GRAPH_CRUNCH 17
 #define STATS 18
 #define SEQUENTIAL_LEVELIZE 19
+#define GROUP_SOFT_LOGIC_VALUE 20
 #define RESOLVE_DFS_VALUE 30
 
 /* unique numbers for using void *data entries in some of the datastructures */
@@ -81,6 +82,7 @@ struct nnode_t;
 struct npin_t;
 struct nnet_t;
 struct netlist_t;
+struct netlist_arena_t;
 
 /* the global arguments of the software */
 struct global_args_t {
@@ -159,6 +161,21 @@ struct global_args_t {
     // Arguments for mixing hard and soft logic
     argparse::ArgValue<int> exact_mults;
     argparse::ArgValue<float> mults_ratio;
+
+    // Emit ripple adders and mux banks of the soft logic as wide cells
+    argparse::ArgValue<bool> group_soft_logic;
+
+    // Soft multiplier architecture: array, tree (Dadda), booth (radix-4, signed only) or auto (picked per node)
+    argparse::ArgValue<std::string> soft_multiplier;
+
+    // Largest shift-and-add network a constant multiplication is rewritten into when hard multipliers exist
+    argparse::ArgValue<int> const_mult_adders;
+
+    // Mapping of memories with more than two read ports: mux (one memory), replicate (copies) or auto (picked per memory)
+    argparse::ArgValue<std::string> read_port_mapping;
+
+    // LUTs one block ram is worth when -read_ports auto weighs memory copies against read muxes
+    argparse::ArgValue<int> bram_lut_cost;
 };
 
 extern const char *ZERO_GND_ZERO;
@@ -529,11 +546,13 @@ struct nnode_t {
 
     npin_t **input_pins; // the input pins
     long num_input_pins;
+    long input_pins_capacity; // allocated slots in input_pins
     int *input_port_sizes; // info about the input ports
     int num_input_port_sizes;
 
     npin_t **output_pins; // the output pins
     long num_output_pins;
+    long output_pins_capacity; // allocated slots in output_pins
     int *output_port_sizes; // info if there is ports
     int num_output_port_sizes;
 
@@ -564,6 +583,12 @@ struct nnode_t {
     // mixing optimization.
     //  value of -1 is reserved for hardened blocks
     long weight = 0;
+
+    // the multiplier iterate_multipliers split this node from and the hard
+    // multipliers that multiplier takes, so the mixing optimization can
+    // allocate its pieces together.  -1 until iterate_multipliers sees the node
+    long split_group = -1;
+    int split_fragments = 0;
 };
 
 struct npin_t {
@@ -594,14 +619,20 @@ struct nnet_t {
     short combined;
 
     int num_driver_pins;
-    npin_t **driver_pins; // the pin that drives the net
+    npin_t **driver_pins;      // the pin that drives the net
+    long driver_pins_capacity; // allocated slots in driver_pins
 
-    npin_t **fanout_pins; // the pins pointed to by the net
-    int num_fanout_pins;  // the list size of pins
+    npin_t **fanout_pins;      // the pins pointed to by the net
+    int num_fanout_pins;       // the list size of pins
+    long fanout_pins_capacity; // allocated slots in fanout_pins
 
     short unique_net_data_id;
     void *net_data;
 
+    // the bit carrying the net in the yosys module, resolved once while updating the design
+    Yosys::RTLIL::SigBit yosys_bit;
+    bool has_yosys_bit;
+
     uintptr_t traverse_visited;
     stat_t stat;
     /////////////////////
@@ -612,6 +643,7 @@ struct nnet_t {
 struct signal_list_t {
     npin_t **pins;
     long count;
+    long capacity; // allocated slots in pins
 
     char is_memory;
     char is_adder;
@@ -628,12 +660,15 @@ struct netlist_t {
     nnet_t *pad_net;
     nnode_t **top_input_nodes;
     int num_top_input_nodes;
+    long top_input_nodes_capacity;
     nnode_t **top_output_nodes;
     int num_top_output_nodes;
+    long top_output_nodes_capacity;
     nnode_t **ff_nodes;
     int num_ff_nodes;
     nnode_t **internal_nodes;
     int num_internal_nodes;
+    long internal_nodes_capacity;
     nnode_t **clocks;
     int num_clocks;
 
@@ -659,6 +694,9 @@ struct netlist_t {
     STRING_CACHE *out_pins_sc;
     STRING_CACHE *nodes_sc;
 
+    /* slab pools backing the nodes, pins and nets of this netlist */
+    netlist_arena_t *arena;
+
     long long num_of_type[operation_list_END];
     long long num_of_node;
     long long num_logic_element;
@@ -85,24 +85,44 @@ const char *node_name_based_on_op(nnode_t *node) { return name_based_on_op(node-
  *-------------------------------------------------------------------------------------------*/
 char *make_full_ref_name(const char *previous, const char * /*module_name*/, const char *module_instance_name, const char *signal_name, long bit)
 {
-    std::stringstream return_string;
-    if (previous)
-        return_string << previous;
+    /* this runs for every generated gate, so size the name once and fill it in place */
+    char bit_string[24] = "";
+    if (bit != -1) {
+        oassert(signal_name);
+        snprintf(bit_string, sizeof(bit_string), "~%ld", bit);
+    }
+
+    size_t previous_len = (previous) ? strlen(previous) : 0;
+    size_t instance_len = (module_instance_name) ? strlen(module_instance_name) : 0;
+    size_t signal_len = (signal_name) ? strlen(signal_name) : 0;
+    bool has_separator = signal_name && (previous || module_instance_name);
 
-    if (module_instance_name)
-        return_string << "." << module_instance_name;
+    char *return_string = (char *)vtr::malloc(previous_len + (module_instance_name ? 1 + instance_len : 0) + (has_separator ? 1 : 0) + signal_len +
+                                              strlen(bit_string) + 1);
+    char *end = return_string;
 
-    if (signal_name && (previous || module_instance_name))
-        return_string << "^";
+    if (previous) {
+        memcpy(end, previous, previous_len);
+        end += previous_len;
+    }
 
-    if (signal_name)
-        return_string << signal_name;
+    if (module_instance_name) {
+        *end++ = '.';
+        memcpy(end, module_instance_name, instance_len);
+        end += instance_len;
+    }
 
-    if (bit != -1) {
-        oassert(signal_name);
-        return_string << "~" << std::dec << bit;
+    if (has_separator)
+        *end++ = '^';
+
+    if (signal_name) {
+        memcpy(end, signal_name, signal_len);
+        end += signal_len;
     }
-    return vtr::strdup(return_string.str().c_str());
+
+    strcpy(end, bit_string);
+
+    return return_string;
 }
 
 /*---------------------------------------------------------------------------------------------
@@ -122,13 +142,21 @@ std::string make_simple_name(char *input, const char *flatten_string, char flatt
     return input_str;
 }
 
+static long int m_id = 0;
+
+/*-----------------------------------------------------------------------
+ * (function: next_unique_id )
+ * 	hands out the unique_id of the next netlist structure, shared by
+ * 	the heap and the arena allocated structures
+ *-----------------------------------------------------------------*/
+long next_unique_id() { return m_id++; }
+
 /*-----------------------------------------------------------------------
  * (function: my_malloc_struct )
  *-----------------------------------------------------------------*/
 void *my_malloc_struct(long bytes_to_alloc)
 {
     void *allocated = vtr::calloc(1, bytes_to_alloc);
-    static long int m_id = 0;
 
     // ways to stop the execution at the point when a specific structure is built...note it needs to be m_id - 1 ... it's unique_id in most data
     // structures
@@ -140,7 +168,7 @@ void *my_malloc_struct(long bytes_to_alloc)
     }
 
     /* mark the unique_id */
-    *((long int *)allocated) = m_id++;
+    *((long int *)allocated) = next_unique_id();
 
     return allocated;
 }
@@ -162,8 +190,13 @@ char *append_string(const char *string, const char *appendage, ...)
     vsnprintf(buffer, vtr::bufsize * sizeof(char), appendage, ap);
     va_end(ap);
 
-    std::string new_string = std::string(string) + std::string(buffer);
-    return vtr::strdup(new_string.c_str());
+    size_t string_len = strlen(string);
+    size_t buffer_len = strlen(buffer);
+
+    char *new_string = (char *)vtr::malloc(string_len + buffer_len + 1);
+    memcpy(new_string, string, string_len);
+    memcpy(new_string + string_len, buffer, buffer_len + 1);
+    return new_string;
 }
 
 void passed_verify_i_o_availabilty(nnode_t *node, int expected_input_size, int expected_output_size, const char *current_src, int line_src)
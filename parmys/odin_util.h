@@ -15,6 +15,7 @@ char *make_full_ref_name(const char *previous, const char *module_name, const ch
 std::string make_simple_name(char *input, const char *flatten_string, char flatten_char);
 
 void *my_malloc_struct(long bytes_to_alloc);
+long next_unique_id();
 
 char *append_string(const char *string, const char *appendage, ...);
 
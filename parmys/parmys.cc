@@ -18,6 +18,7 @@
  */
 
 #include "kernel/celltypes.h"
+#include "kernel/sigtools.h"
 #include "kernel/yosys.h"
 
 #include <regex>
@@ -51,6 +52,8 @@
 #include "subtractions.h"
 
 #include "ast_util.h"
+#include "parmys_capacity.hpp"
+#include "parmys_profile.hpp"
 #include "parmys_update.hpp"
 #include "parmys_utils.hpp"
 
@@ -61,46 +64,45 @@ PRIVATE_NAMESPACE_BEGIN
 #define VCC_NAME "$true"
 #define HBPAD_NAME "$undef"
 
-struct Bbox {
-    std::string name;
-    std::vector<std::string> inputs, outputs;
+CellTypes ct;
+
+/* an input pin waiting for the net driving its signal bit */
+struct pin_hookup_t {
+    npin_t *pin;
+    SigBit bit;
 };
 
-CellTypes ct;
+/* nets of the netlist being built, keyed on the driven signal bit */
+typedef dict<SigBit, nnet_t *> bit_net_map_t;
 
 struct ParMYSPass : public Pass {
 
-    static void hook_up_nets(netlist_t *odin_netlist, Hashtable *output_nets_hash)
+    /* all undefined constants (x, z, ...) share the pad net */
+    static SigBit net_key(const SigBit &bit)
     {
-        nnode_t **node_sets[] = {odin_netlist->internal_nodes, odin_netlist->ff_nodes, odin_netlist->top_output_nodes};
-        int counts[] = {odin_netlist->num_internal_nodes, odin_netlist->num_ff_nodes, odin_netlist->num_top_output_nodes};
-        int num_sets = 3;
-
-        int i;
-        for (i = 0; i < num_sets; i++) {
-            int j;
-            for (j = 0; j < counts[i]; j++) {
-                nnode_t *node = node_sets[i][j];
-                hook_up_node(node, output_nets_hash);
-            }
-        }
+        if (bit.wire != NULL || bit == RTLIL::State::S0 || bit == RTLIL::State::S1)
+            return bit;
+
+        return SigBit(RTLIL::State::Sx);
     }
 
-    static void hook_up_node(nnode_t *node, Hashtable *output_nets_hash)
+    static void hook_up_nets(bit_net_map_t &output_nets, const std::vector<pin_hookup_t> &internal_pins, const std::vector<pin_hookup_t> &output_pins)
     {
-        int j;
-        for (j = 0; j < node->num_input_pins; j++) {
-            npin_t *input_pin = node->input_pins[j];
+        /* internal nodes first, then the top outputs, as the fanout order used to be */
+        const std::vector<pin_hookup_t> *pin_sets[] = {&internal_pins, &output_pins};
 
-            nnet_t *output_net = (nnet_t *)output_nets_hash->get(input_pin->name);
+        for (auto pins : pin_sets) {
+            for (auto &hookup : *pins) {
+                auto it = output_nets.find(net_key(hookup.bit));
 
-            if (!output_net)
-                log_error("Error: Could not hook up the pin %s: not available, related node: %s.", input_pin->name, node->name);
-            add_fanout_pin_to_net(output_net, input_pin);
+                if (it == output_nets.end())
+                    log_error("Error: Could not hook up the pin %s: not available, related node: %s.", hookup.pin->name, hookup.pin->node->name);
+                add_fanout_pin_to_net(it->second, hookup.pin);
+            }
         }
     }
 
-    static void build_top_output_node(const char *name_str, netlist_t *odin_netlist)
+    static nnode_t *build_top_output_node(const char *name_str, SigBit bit, netlist_t *odin_netlist, std::vector<pin_hookup_t> &output_pins)
     {
         nnode_t *new_node = allocate_nnode(my_location);
         new_node->related_ast_node = NULL;
@@ -112,13 +114,16 @@ struct ParMYSPass : public Pass {
         npin_t *new_pin = allocate_npin();
         new_pin->name = vtr::strdup(name_str);
         add_input_pin_to_node(new_node, new_pin, 0);
+        output_pins.push_back({new_pin, bit});
 
         odin_netlist->top_output_nodes =
-          (nnode_t **)vtr::realloc(odin_netlist->top_output_nodes, sizeof(nnode_t *) * (odin_netlist->num_top_output_nodes + 1));
+          grow_array(odin_netlist->top_output_nodes, odin_netlist->top_output_nodes_capacity, odin_netlist->num_top_output_nodes + 1);
         odin_netlist->top_output_nodes[odin_netlist->num_top_output_nodes++] = new_node;
+
+        return new_node;
     }
 
-    static void build_top_input_node(const char *name_str, netlist_t *odin_netlist, Hashtable *output_nets_hash)
+    static nnode_t *build_top_input_node(const char *name_str, SigBit bit, netlist_t *odin_netlist, bit_net_map_t &output_nets)
     {
         loc_t my_loc;
         nnode_t *new_node = allocate_nnode(my_loc);
@@ -143,13 +148,15 @@ struct ParMYSPass : public Pass {
         add_driver_pin_to_net(new_net, new_pin);
 
         odin_netlist->top_input_nodes =
-          (nnode_t **)vtr::realloc(odin_netlist->top_input_nodes, sizeof(nnode_t *) * (odin_netlist->num_top_input_nodes + 1));
+          grow_array(odin_netlist->top_input_nodes, odin_netlist->top_input_nodes_capacity, odin_netlist->num_top_input_nodes + 1);
         odin_netlist->top_input_nodes[odin_netlist->num_top_input_nodes++] = new_node;
 
-        output_nets_hash->add(name_str, new_net);
+        output_nets[bit] = new_net;
+
+        return new_node;
     }
 
-    static void create_top_driver_nets(netlist_t *odin_netlist, Hashtable *output_nets_hash)
+    static void create_top_driver_nets(netlist_t *odin_netlist, bit_net_map_t &output_nets)
     {
         npin_t *new_pin;
 
@@ -185,26 +192,23 @@ struct ParMYSPass : public Pass {
 
         /* CREATE the driver for the ZERO */
         odin_netlist->zero_net->name = make_full_ref_name(odin_netlist->identifier, NULL, NULL, zero_string, -1);
-        output_nets_hash->add(GND_NAME, odin_netlist->zero_net);
+        output_nets[SigBit(RTLIL::State::S0)] = odin_netlist->zero_net;
 
         /* CREATE the driver for the ONE and store twice */
         odin_netlist->one_net->name = make_full_ref_name(odin_netlist->identifier, NULL, NULL, one_string, -1);
-        output_nets_hash->add(VCC_NAME, odin_netlist->one_net);
+        output_nets[SigBit(RTLIL::State::S1)] = odin_netlist->one_net;
 
         /* CREATE the driver for the PAD */
         odin_netlist->pad_net->name = make_full_ref_name(odin_netlist->identifier, NULL, NULL, pad_string, -1);
-        output_nets_hash->add(HBPAD_NAME, odin_netlist->pad_net);
+        output_nets[SigBit(RTLIL::State::Sx)] = odin_netlist->pad_net;
 
         odin_netlist->vcc_node->name = vtr::strdup(VCC_NAME);
         odin_netlist->gnd_node->name = vtr::strdup(GND_NAME);
         odin_netlist->pad_node->name = vtr::strdup(HBPAD_NAME);
     }
 
-    static char *sig_full_ref_name_sig(RTLIL::SigBit sig, pool<SigBit> &cstr_bits_seen)
+    static char *sig_full_ref_name_sig(RTLIL::SigBit sig)
     {
-
-        cstr_bits_seen.insert(sig);
-
         if (sig.wire == NULL) {
             if (sig == RTLIL::State::S0)
                 return vtr::strdup(GND_NAME);
@@ -223,32 +227,44 @@ struct ParMYSPass : public Pass {
         }
     }
 
-    static void map_input_port(const RTLIL::IdString &mapping, SigSpec in_port, nnode_t *node, pool<SigBit> &cstr_bits_seen)
+    static void map_input_port(const RTLIL::IdString &mapping, SigSpec in_port, nnode_t *node, std::vector<pin_hookup_t> &internal_pins)
     {
 
         int base_pin_idx = node->num_input_pins;
+        std::string mapping_name = RTLIL::unescape_id(mapping);
 
         allocate_more_input_pins(node, in_port.size());
         add_input_port_information(node, in_port.size());
 
         for (int i = 0; i < in_port.size(); i++) {
-
-            char *in_pin_name = sig_full_ref_name_sig(in_port[i], cstr_bits_seen);
-
             npin_t *in_pin = allocate_npin();
-            in_pin->name = vtr::strdup(in_pin_name);
-            in_pin->mapping = vtr::strdup(RTLIL::unescape_id(mapping).c_str());
+            in_pin->name = sig_full_ref_name_sig(in_port[i]);
+            in_pin->mapping = vtr::strdup(mapping_name.c_str());
             add_input_pin_to_node(node, in_pin, base_pin_idx + i);
+            internal_pins.push_back({in_pin, in_port[i]});
+        }
+    }
 
-            vtr::free(in_pin_name);
+    /*---------------------------------------------------------------------------------------------
+     * (function: get_output_net)
+     * 	Returns the net driving bit, the name is only built when the net is created
+     *-------------------------------------------------------------------------------------------*/
+    static nnet_t *get_output_net(SigBit bit, bit_net_map_t &output_nets)
+    {
+        nnet_t *&out_net = output_nets[net_key(bit)];
+        if (out_net == nullptr) {
+            out_net = allocate_nnet();
+            out_net->name = sig_full_ref_name_sig(bit);
         }
+
+        return out_net;
     }
 
-    static void map_output_port(const RTLIL::IdString &mapping, SigSpec out_port, nnode_t *node, Hashtable *output_nets_hash,
-                                pool<SigBit> &cstr_bits_seen)
+    static void map_output_port(const RTLIL::IdString &mapping, SigSpec out_port, nnode_t *node, bit_net_map_t &output_nets)
     {
 
         int base_pin_idx = node->num_output_pins;
+        std::string mapping_name = RTLIL::unescape_id(mapping);
 
         allocate_more_output_pins(node, out_port.size()); //?
         add_output_port_information(node, out_port.size());
@@ -258,19 +274,10 @@ struct ParMYSPass : public Pass {
         for (int i = 0; i < out_port.size(); i++) {
             npin_t *out_pin = allocate_npin();
             out_pin->name = NULL;
-            out_pin->mapping = vtr::strdup(RTLIL::unescape_id(mapping).c_str());
+            out_pin->mapping = vtr::strdup(mapping_name.c_str());
             add_output_pin_to_node(node, out_pin, base_pin_idx + i);
 
-            char *output_pin_name = sig_full_ref_name_sig(out_port[i], cstr_bits_seen);
-            nnet_t *out_net = (nnet_t *)output_nets_hash->get(output_pin_name);
-            if (out_net == nullptr) {
-                out_net = allocate_nnet();
-                out_net->name = vtr::strdup(output_pin_name);
-                output_nets_hash->add(output_pin_name, out_net);
-            }
-            add_driver_pin_to_net(out_net, out_pin);
-
-            vtr::free(output_pin_name);
+            add_driver_pin_to_net(get_output_net(out_port[i], output_nets), out_pin);
         }
     }
 
@@ -354,345 +361,370 @@ struct ParMYSPass : public Pass {
         return NO_OP;
     }
 
-    static netlist_t *to_netlist(RTLIL::Module *top_module, RTLIL::Design *design)
+    /*---------------------------------------------------------------------------------------------
+     * (function: cell_type)
+     * 	Returns the odin node type of cell, cells of hard blocks that are already black boxed in
+     * 	the design are skipped
+     *-------------------------------------------------------------------------------------------*/
+    static operation_list cell_type(RTLIL::Cell *cell, RTLIL::Design *design)
     {
-        ct.setup();
-
-        std::vector<RTLIL::Module *> mod_list;
-
-        std::vector<RTLIL::Module *> black_list;
-
-        std::string top_module_name;
-        if (top_module_name.empty())
-            for (auto module : design->modules())
-                if (module->get_bool_attribute(ID::top))
-                    top_module_name = module->name.str();
-
-        for (auto module : design->modules()) {
-
-            if (module->processes.size() != 0)
-                log_error("Found unmapped processes in module %s: unmapped processes are not supported in parmys pass!\n", log_id(module->name));
-            if (module->memories.size() != 0)
-                log_error("Found unmapped memories in module %s: unmapped memories are not supported in parmys pass!\n", log_id(module->name));
+        operation_list type = from_yosys_type(cell->type);
 
-            if (module->name == RTLIL::escape_id(top_module_name)) {
-                top_module_name.clear();
-                continue;
+        // check primitive node type is alreday mapped before or not (blackboxed)
+        if (type == SPRAM || type == DPRAM || type == ADD || type == MULTIPLY) {
+            if (design->module(cell->type) != nullptr && design->module(cell->type)->get_blackbox_attribute()) {
+                type = SKIP;
             }
+        }
 
-            mod_list.push_back(module);
+        if (type == NO_OP) {
+
+            /**
+             *  according to ast.cc:1657-1663
+             *
+             * 	std::string modname;
+             *	if (parameters.size() == 0)
+             *		modname = stripped_name;
+             *	else if (para_info.size() > 60)
+             *		modname = "$paramod$" + sha1(para_info) + stripped_name;
+             *	else
+             *		modname = "$paramod" + stripped_name + para_info;
+             */
+
+            if (cell->type.begins_with("$paramod$")) // e.g. $paramod$b509a885304d9c8c49f505bb9d0e99a9fb676562\dual_port_ram
+            {
+                std::regex regex("^\\$paramod\\$\\w+\\\\(\\w+)$");
+                std::smatch m;
+                std::string modname(str(cell->type));
+                if (regex_match(modname, m, regex)) {
+                    type = yosys_subckt_strmap[m.str(1).c_str()];
+                }
+            } else if (cell->type.begins_with("$paramod\\")) // e.g. $paramod\dual_port_ram\ADDR_WIDTH?4'0100\DATA_WIDTH?4'0101
+            {
+                std::regex regex("^\\$paramod\\\\(\\w+)(\\\\\\S+)*$");
+                std::smatch m;
+                std::string modname(str(cell->type));
+                if (regex_match(modname, m, regex)) {
+                    type = yosys_subckt_strmap[m.str(1).c_str()];
+                }
+            } else if (design->module(cell->type)->get_blackbox_attribute()) {
+                type = SKIP;
+            } else {
+                type = HARD_IP;
+            }
         }
 
-        pool<SigBit> cstr_bits_seen;
+        return type;
+    }
 
-        netlist_t *odin_netlist = allocate_netlist();
-        odin_netlist->design = design;
-        Hashtable *output_nets_hash = new Hashtable();
-        odin_netlist->identifier = vtr::strdup(log_id(top_module->name));
+    /*---------------------------------------------------------------------------------------------
+     * (function: build_cell_node)
+     * 	Adds the node of cell to the netlist, its ports are connected to the nets of the bits
+     * 	sigmap maps them to
+     *-------------------------------------------------------------------------------------------*/
+    static nnode_t *build_cell_node(RTLIL::Cell *cell, operation_list type, const SigMap &sigmap, netlist_t *odin_netlist, bit_net_map_t &output_nets,
+                                    std::vector<pin_hookup_t> &internal_pins, long &hard_id)
+    {
+        nnode_t *new_node = allocate_nnode(my_location);
 
-        create_top_driver_nets(odin_netlist, output_nets_hash);
+        for (auto &param : cell->parameters) {
+            new_node->cell_parameters[Yosys::RTLIL::IdString(param.first)] = Yosys::Const(param.second);
+        }
 
-        // build_top_input_node(DEFAULT_CLOCK_NAME, odin_netlist, output_nets_hash);
+        new_node->related_ast_node = NULL;
+        new_node->type = type;
 
-        std::map<int, RTLIL::Wire *> inputs, outputs;
+        if (new_node->type == HARD_IP) {
+            t_model *hb_model = find_hard_block(str(cell->type).c_str());
+            if (hb_model) {
+                hb_model->used = 1;
+            }
+        }
 
-        for (auto wire : top_module->wires()) {
-            if (wire->port_input)
-                inputs[wire->port_id] = wire;
-            if (wire->port_output)
-                outputs[wire->port_id] = wire;
+        if (new_node->type == HARD_IP || new_node->type == SKIP) {
+            std::string modname(str(cell->type));
+            // fake ast node.
+            new_node->related_ast_node = create_node_w_type(HARD_BLOCK, my_location);
+            new_node->related_ast_node->children = (ast_node_t **)vtr::calloc(1, sizeof(ast_node_t *));
+            new_node->related_ast_node->identifier_node = create_tree_node_id(vtr::strdup(modname.c_str()), my_location);
         }
 
-        for (auto &it : inputs) {
-            RTLIL::Wire *wire = it.second;
-            for (int i = 0; i < wire->width; i++) {
-                char *name_string = sig_full_ref_name_sig(RTLIL::SigBit(wire, i), cstr_bits_seen);
-                build_top_input_node(name_string, odin_netlist, output_nets_hash);
-                vtr::free(name_string);
+        for (auto &conn : cell->connections()) {
+
+            if (cell->input(conn.first) && conn.second.size() > 0) {
+                map_input_port(conn.first, sigmap(conn.second), new_node, internal_pins);
             }
-        }
 
-        for (auto &it : outputs) {
-            RTLIL::Wire *wire = it.second;
-            for (int i = 0; i < wire->width; i++) {
-                char *name_string = sig_full_ref_name_sig(RTLIL::SigBit(wire, i), cstr_bits_seen);
-                build_top_output_node(name_string, odin_netlist);
-                vtr::free(name_string);
+            if (cell->output(conn.first) && conn.second.size() > 0) {
+                map_output_port(conn.first, sigmap(conn.second), new_node, output_nets);
             }
         }
 
-        long hard_id = 0;
-        for (auto cell : top_module->cells()) {
+        if (is_param_required(new_node->type)) {
 
-            nnode_t *new_node = allocate_nnode(my_location);
+            if (cell->hasParam(ID::SRST_VALUE)) {
+                auto value = vtr::strdup(cell->getParam(ID::SRST_VALUE).as_string().c_str());
+                new_node->attributes->sreset_value = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
+            }
 
-            for (auto &param : cell->parameters) {
-                new_node->cell_parameters[Yosys::RTLIL::IdString(param.first)] = Yosys::Const(param.second);
+            if (cell->hasParam(ID::ARST_VALUE)) {
+                auto value = vtr::strdup(cell->getParam(ID::ARST_VALUE).as_string().c_str());
+                new_node->attributes->areset_value = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
             }
 
-            new_node->related_ast_node = NULL;
+            if (cell->hasParam(ID::OFFSET)) {
+                auto value = vtr::strdup(cell->getParam(ID::OFFSET).as_string().c_str());
+                new_node->attributes->offset = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
+            }
 
-            // new_node->type = yosys_subckt_strmap[str(cell->type).c_str()];
-            new_node->type = from_yosys_type(cell->type);
+            if (cell->hasParam(ID::SIZE)) {
+                auto value = vtr::strdup(cell->getParam(ID::SIZE).as_string().c_str());
+                new_node->attributes->size = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
+            }
 
-            // check primitive node type is alreday mapped before or not (blackboxed)
-            if (new_node->type == SPRAM || new_node->type == DPRAM || new_node->type == ADD || new_node->type == MULTIPLY) {
-                if (design->module(cell->type) != nullptr && design->module(cell->type)->get_blackbox_attribute()) {
-                    new_node->type = SKIP;
-                }
+            if (cell->hasParam(ID::WIDTH)) {
+                auto value = vtr::strdup(cell->getParam(ID::WIDTH).as_string().c_str());
+                new_node->attributes->DBITS = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
             }
 
-            if (new_node->type == NO_OP) {
-
-                /**
-                 *  according to ast.cc:1657-1663
-                 *
-                 * 	std::string modname;
-                 *	if (parameters.size() == 0)
-                 *		modname = stripped_name;
-                 *	else if (para_info.size() > 60)
-                 *		modname = "$paramod$" + sha1(para_info) + stripped_name;
-                 *	else
-                 *		modname = "$paramod" + stripped_name + para_info;
-                 */
-
-                if (cell->type.begins_with("$paramod$")) // e.g. $paramod$b509a885304d9c8c49f505bb9d0e99a9fb676562\dual_port_ram
-                {
-                    std::regex regex("^\\$paramod\\$\\w+\\\\(\\w+)$");
-                    std::smatch m;
-                    std::string modname(str(cell->type));
-                    if (regex_match(modname, m, regex)) {
-                        new_node->type = yosys_subckt_strmap[m.str(1).c_str()];
-                    }
-                } else if (cell->type.begins_with("$paramod\\")) // e.g. $paramod\dual_port_ram\ADDR_WIDTH?4'0100\DATA_WIDTH?4'0101
-                {
-                    std::regex regex("^\\$paramod\\\\(\\w+)(\\\\\\S+)*$");
-                    std::smatch m;
-                    std::string modname(str(cell->type));
-                    if (regex_match(modname, m, regex)) {
-                        new_node->type = yosys_subckt_strmap[m.str(1).c_str()];
-                    }
-                } else if (design->module(cell->type)->get_blackbox_attribute()) {
-                    new_node->type = SKIP;
-                } else {
-                    new_node->type = HARD_IP;
-                    t_model *hb_model = find_hard_block(str(cell->type).c_str());
-                    if (hb_model) {
-                        hb_model->used = 1;
-                    }
-                    std::string modname(str(cell->type));
-                    // Create a fake ast node.
-                    if (new_node->type == HARD_IP) {
-                        new_node->related_ast_node = create_node_w_type(HARD_BLOCK, my_location);
-                        new_node->related_ast_node->children = (ast_node_t **)vtr::calloc(1, sizeof(ast_node_t *));
-                        new_node->related_ast_node->identifier_node = create_tree_node_id(vtr::strdup(modname.c_str()), my_location);
-                    }
-                }
+            if (cell->hasParam(ID::RD_PORTS)) {
+                auto value = vtr::strdup(cell->getParam(ID::RD_PORTS).as_string().c_str());
+                new_node->attributes->RD_PORTS = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
             }
 
-            if (new_node->type == SKIP) {
-                std::string modname(str(cell->type));
-                // fake ast node.
-                new_node->related_ast_node = create_node_w_type(HARD_BLOCK, my_location);
-                new_node->related_ast_node->children = (ast_node_t **)vtr::calloc(1, sizeof(ast_node_t *));
-                new_node->related_ast_node->identifier_node = create_tree_node_id(vtr::strdup(modname.c_str()), my_location);
+            if (cell->hasParam(ID::WR_PORTS)) {
+                auto value = vtr::strdup(cell->getParam(ID::WR_PORTS).as_string().c_str());
+                new_node->attributes->WR_PORTS = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
             }
 
-            for (auto &conn : cell->connections()) {
+            if (cell->hasParam(ID::ABITS)) {
+                auto value = vtr::strdup(cell->getParam(ID::ABITS).as_string().c_str());
+                new_node->attributes->ABITS = std::bitset<sizeof(long) * 8>(value).to_ulong();
+                vtr::free(value);
+            }
 
-                if (cell->input(conn.first) && conn.second.size() > 0) {
-                    map_input_port(conn.first, conn.second, new_node, cstr_bits_seen);
-                }
+            if (cell->hasParam(ID::MEMID)) {
+                auto value = vtr::strdup(cell->getParam(ID::MEMID).as_string().c_str());
+                RTLIL::IdString ids = cell->getParam(ID::MEMID).decode_string();
+                new_node->attributes->memory_id = vtr::strdup(RTLIL::unescape_id(ids).c_str());
+                vtr::free(value);
+            }
 
-                if (cell->output(conn.first) && conn.second.size() > 0) {
-                    map_output_port(conn.first, conn.second, new_node, output_nets_hash, cstr_bits_seen);
-                }
+            if (cell->hasParam(ID::A_SIGNED)) {
+                new_node->attributes->port_a_signed = cell->getParam(ID::A_SIGNED).as_bool() ? SIGNED : UNSIGNED;
             }
 
-            if (is_param_required(new_node->type)) {
+            if (cell->hasParam(ID::B_SIGNED)) {
+                new_node->attributes->port_b_signed = cell->getParam(ID::B_SIGNED).as_bool() ? SIGNED : UNSIGNED;
+            }
 
-                if (cell->hasParam(ID::SRST_VALUE)) {
-                    auto value = vtr::strdup(cell->getParam(ID::SRST_VALUE).as_string().c_str());
-                    new_node->attributes->sreset_value = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::CLK_POLARITY)) {
+                new_node->attributes->clk_edge_type =
+                  cell->getParam(ID::CLK_POLARITY).as_bool() ? RISING_EDGE_SENSITIVITY : FALLING_EDGE_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::ARST_VALUE)) {
-                    auto value = vtr::strdup(cell->getParam(ID::ARST_VALUE).as_string().c_str());
-                    new_node->attributes->areset_value = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::CLR_POLARITY)) {
+                new_node->attributes->clr_polarity =
+                  cell->getParam(ID::CLR_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::OFFSET)) {
-                    auto value = vtr::strdup(cell->getParam(ID::OFFSET).as_string().c_str());
-                    new_node->attributes->offset = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::SET_POLARITY)) {
+                new_node->attributes->set_polarity =
+                  cell->getParam(ID::SET_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::SIZE)) {
-                    auto value = vtr::strdup(cell->getParam(ID::SIZE).as_string().c_str());
-                    new_node->attributes->size = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::EN_POLARITY)) {
+                new_node->attributes->enable_polarity =
+                  cell->getParam(ID::EN_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::WIDTH)) {
-                    auto value = vtr::strdup(cell->getParam(ID::WIDTH).as_string().c_str());
-                    new_node->attributes->DBITS = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::ARST_POLARITY)) {
+                new_node->attributes->areset_polarity =
+                  cell->getParam(ID::ARST_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::RD_PORTS)) {
-                    auto value = vtr::strdup(cell->getParam(ID::RD_PORTS).as_string().c_str());
-                    new_node->attributes->RD_PORTS = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::SRST_POLARITY)) {
+                new_node->attributes->sreset_polarity =
+                  cell->getParam(ID::SRST_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::WR_PORTS)) {
-                    auto value = vtr::strdup(cell->getParam(ID::WR_PORTS).as_string().c_str());
-                    new_node->attributes->WR_PORTS = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::RD_CLK_ENABLE)) {
+                new_node->attributes->RD_CLK_ENABLE =
+                  cell->getParam(ID::RD_CLK_ENABLE).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::ABITS)) {
-                    auto value = vtr::strdup(cell->getParam(ID::ABITS).as_string().c_str());
-                    new_node->attributes->ABITS = std::bitset<sizeof(long) * 8>(value).to_ulong();
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::WR_CLK_ENABLE)) {
+                new_node->attributes->WR_CLK_ENABLE =
+                  cell->getParam(ID::WR_CLK_ENABLE).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::MEMID)) {
-                    auto value = vtr::strdup(cell->getParam(ID::MEMID).as_string().c_str());
-                    RTLIL::IdString ids = cell->getParam(ID::MEMID).decode_string();
-                    new_node->attributes->memory_id = vtr::strdup(RTLIL::unescape_id(ids).c_str());
-                    vtr::free(value);
-                }
+            if (cell->hasParam(ID::RD_CLK_POLARITY)) {
+                new_node->attributes->RD_CLK_POLARITY =
+                  cell->getParam(ID::RD_CLK_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
 
-                if (cell->hasParam(ID::A_SIGNED)) {
-                    new_node->attributes->port_a_signed = cell->getParam(ID::A_SIGNED).as_bool() ? SIGNED : UNSIGNED;
-                }
+            if (cell->hasParam(ID::WR_CLK_POLARITY)) {
+                new_node->attributes->WR_CLK_POLARITY =
+                  cell->getParam(ID::WR_CLK_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
+            }
+        }
 
-                if (cell->hasParam(ID::B_SIGNED)) {
-                    new_node->attributes->port_b_signed = cell->getParam(ID::B_SIGNED).as_bool() ? SIGNED : UNSIGNED;
-                }
+        if (new_node->type == SMUX_2) {
+            new_node->name = vtr::strdup(new_node->output_pins[0]->net->name);
+        } else {
+            new_node->name = vtr::strdup(
+              stringf("%s~%ld", (((new_node->type == HARD_IP /*|| new_node->type == SKIP*/) ? "\\" : "") + str(cell->type)).c_str(), hard_id++).c_str());
+        }
 
-                if (cell->hasParam(ID::CLK_POLARITY)) {
-                    new_node->attributes->clk_edge_type =
-                      cell->getParam(ID::CLK_POLARITY).as_bool() ? RISING_EDGE_SENSITIVITY : FALLING_EDGE_SENSITIVITY;
-                }
+        /*add this node to blif_netlist as an internal node */
+        odin_netlist->internal_nodes =
+          grow_array(odin_netlist->internal_nodes, odin_netlist->internal_nodes_capacity, odin_netlist->num_internal_nodes + 1);
+        odin_netlist->internal_nodes[odin_netlist->num_internal_nodes++] = new_node;
 
-                if (cell->hasParam(ID::CLR_POLARITY)) {
-                    new_node->attributes->clr_polarity =
-                      cell->getParam(ID::CLR_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+        return new_node;
+    }
 
-                if (cell->hasParam(ID::SET_POLARITY)) {
-                    new_node->attributes->set_polarity =
-                      cell->getParam(ID::SET_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+    /* SKIP cells always stay in the module as they are, -partial also keeps the cells odin would only rewrite */
+    static bool is_extracted_type(operation_list type, bool partial)
+    {
+        if (type == SKIP)
+            return false;
 
-                if (cell->hasParam(ID::EN_POLARITY)) {
-                    new_node->attributes->enable_polarity =
-                      cell->getParam(ID::EN_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+        if (!partial)
+            return true;
 
-                if (cell->hasParam(ID::ARST_POLARITY)) {
-                    new_node->attributes->areset_polarity =
-                      cell->getParam(ID::ARST_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+        switch (type) {
+        case (ADD):
+        case (MINUS):
+        case (MULTIPLY):
+        case (YMEM):
+        case (YMEM2):
+        case (SPRAM):
+        case (DPRAM):
+        case (MEMORY):
+        case (HARD_IP):
+            return true;
+        default:
+            return false;
+        }
+    }
 
-                if (cell->hasParam(ID::SRST_POLARITY)) {
-                    new_node->attributes->sreset_polarity =
-                      cell->getParam(ID::SRST_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+    /*---------------------------------------------------------------------------------------------
+     * (function: to_netlist)
+     * 	Builds the netlist out of the cells of the top module odin has to map (see
+     * 	is_extracted_type). The bits they read from the rest of the module become top input
+     * 	nodes, the bits they drive for it (or for a module output or kept wire) become top output
+     * 	nodes. Both are recorded in extraction so that update_design can put the mapped netlist
+     * 	in place of the cells.
+     *-------------------------------------------------------------------------------------------*/
+    static netlist_t *to_netlist(RTLIL::Module *top_module, RTLIL::Design *design, bool partial, extraction_t &extraction)
+    {
+        ct.setup();
 
-                if (cell->hasParam(ID::RD_CLK_ENABLE)) {
-                    new_node->attributes->RD_CLK_ENABLE =
-                      cell->getParam(ID::RD_CLK_ENABLE).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+        SigMap sigmap(top_module);
+        std::vector<operation_list> cell_types;
+        pool<RTLIL::Cell *> extracted;
+        pool<SigBit> driven_bits;
+        long num_cells = 0;
 
-                if (cell->hasParam(ID::WR_CLK_ENABLE)) {
-                    new_node->attributes->WR_CLK_ENABLE =
-                      cell->getParam(ID::WR_CLK_ENABLE).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+        extraction.module = top_module;
 
-                if (cell->hasParam(ID::RD_CLK_POLARITY)) {
-                    new_node->attributes->RD_CLK_POLARITY =
-                      cell->getParam(ID::RD_CLK_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
+        for (auto cell : top_module->cells()) {
+            operation_list type = cell_type(cell, design);
+            num_cells++;
 
-                if (cell->hasParam(ID::WR_CLK_POLARITY)) {
-                    new_node->attributes->WR_CLK_POLARITY =
-                      cell->getParam(ID::WR_CLK_POLARITY).as_bool() ? ACTIVE_HIGH_SENSITIVITY : ACTIVE_LOW_SENSITIVITY;
-                }
-            }
+            if (!is_extracted_type(type, partial))
+                continue;
 
-            if (new_node->type == SMUX_2) {
-                new_node->name = vtr::strdup(new_node->output_pins[0]->net->name);
-            } else {
-                new_node->name = vtr::strdup(
-                  stringf("%s~%ld", (((new_node->type == HARD_IP /*|| new_node->type == SKIP*/) ? "\\" : "") + str(cell->type)).c_str(), hard_id++)
-                    .c_str());
-            }
+            extraction.cells.push_back(cell);
+            cell_types.push_back(type);
+            extracted.insert(cell);
 
-            /*add this node to blif_netlist as an internal node */
-            odin_netlist->internal_nodes =
-              (nnode_t **)vtr::realloc(odin_netlist->internal_nodes, sizeof(nnode_t *) * (odin_netlist->num_internal_nodes + 1));
-            odin_netlist->internal_nodes[odin_netlist->num_internal_nodes++] = new_node;
+            for (auto &conn : cell->connections())
+                if (cell->output(conn.first))
+                    for (auto bit : sigmap(conn.second))
+                        if (bit.wire != NULL)
+                            driven_bits.insert(bit);
         }
 
-        // add intermediate buffer nodes
-        for (auto &conn : top_module->connections())
-            for (int i = 0; i < conn.first.size(); i++) {
-                SigBit lhs_bit = conn.first[i];
-                SigBit rhs_bit = conn.second[i];
-
-                if (cstr_bits_seen.count(lhs_bit) == 0) // @TODO to be double checked later
-                    continue;
-
-                nnode_t *buf_node = allocate_nnode(my_location);
+        /* bits of the extracted cells the rest of the module still reads */
+        pool<SigBit> used_bits;
+        for (auto cell : top_module->cells()) {
+            if (extracted.count(cell))
+                continue;
 
-                buf_node->related_ast_node = NULL;
+            for (auto &conn : cell->connections())
+                for (auto bit : sigmap(conn.second))
+                    if (driven_bits.count(bit))
+                        used_bits.insert(bit);
+        }
 
-                buf_node->type = BUF_NODE;
+        for (auto wire : top_module->wires()) {
+            if (!wire->port_output && !wire->get_bool_attribute(ID::keep))
+                continue;
 
-                allocate_more_input_pins(buf_node, 1);
-                add_input_port_information(buf_node, 1);
+            for (auto bit : sigmap(RTLIL::SigSpec(wire)))
+                if (driven_bits.count(bit))
+                    used_bits.insert(bit);
+        }
 
-                char *in_pin_name = sig_full_ref_name_sig(rhs_bit, cstr_bits_seen);
-                npin_t *in_pin = allocate_npin();
-                in_pin->name = vtr::strdup(in_pin_name);
-                in_pin->type = INPUT;
-                add_input_pin_to_node(buf_node, in_pin, 0);
+        netlist_t *odin_netlist = allocate_netlist();
+        odin_netlist->design = design;
+        bit_net_map_t output_nets;
+        std::vector<pin_hookup_t> internal_pins;
+        std::vector<pin_hookup_t> output_pins;
+        odin_netlist->identifier = vtr::strdup(log_id(top_module->name));
 
-                vtr::free(in_pin_name);
+        create_top_driver_nets(odin_netlist, output_nets);
 
-                allocate_more_output_pins(buf_node, 1);
-                add_output_port_information(buf_node, 1);
+        for (auto cell : extraction.cells) {
+            for (auto &conn : cell->connections()) {
+                if (!cell->input(conn.first))
+                    continue;
 
-                npin_t *out_pin = allocate_npin();
-                out_pin->name = NULL;
-                add_output_pin_to_node(buf_node, out_pin, 0);
+                for (auto bit : sigmap(conn.second)) {
+                    if (bit.wire == NULL || driven_bits.count(bit) || output_nets.count(bit))
+                        continue;
 
-                char *output_pin_name = sig_full_ref_name_sig(lhs_bit, cstr_bits_seen);
-                nnet_t *out_net = (nnet_t *)output_nets_hash->get(output_pin_name);
-                if (out_net == nullptr) {
-                    out_net = allocate_nnet();
-                    out_net->name = vtr::strdup(output_pin_name);
-                    output_nets_hash->add(output_pin_name, out_net);
+                    std::string name = stringf("$parmys_in~%d", GetSize(extraction.inputs));
+                    extraction.inputs.push_back({build_top_input_node(name.c_str(), bit, odin_netlist, output_nets), bit});
                 }
-                add_driver_pin_to_net(out_net, out_pin);
+            }
+        }
 
-                buf_node->name = vtr::strdup(output_pin_name);
+        long hard_id = 0;
+        for (size_t i = 0; i < extraction.cells.size(); i++)
+            build_cell_node(extraction.cells[i], cell_types[i], sigmap, odin_netlist, output_nets, internal_pins, hard_id);
 
-                odin_netlist->internal_nodes =
-                  (nnode_t **)vtr::realloc(odin_netlist->internal_nodes, sizeof(nnode_t *) * (odin_netlist->num_internal_nodes + 1));
-                odin_netlist->internal_nodes[odin_netlist->num_internal_nodes++] = buf_node;
+        pool<SigBit> outputs_seen;
+        for (auto cell : extraction.cells) {
+            for (auto &conn : cell->connections()) {
+                if (!cell->output(conn.first))
+                    continue;
+
+                for (auto bit : sigmap(conn.second)) {
+                    if (!used_bits.count(bit) || outputs_seen.count(bit))
+                        continue;
 
-                vtr::free(output_pin_name);
+                    std::string name = stringf("$parmys_out~%d", GetSize(extraction.outputs));
+                    extraction.outputs.push_back({build_top_output_node(name.c_str(), bit, odin_netlist, output_pins), bit});
+                    outputs_seen.insert(bit);
+                }
             }
+        }
+
+        hook_up_nets(output_nets, internal_pins, output_pins);
 
-        hook_up_nets(odin_netlist, output_nets_hash);
+        log("Extracted %d of %ld cells, %d boundary inputs and %d boundary outputs\n", GetSize(extraction.cells), num_cells,
+            GetSize(extraction.inputs), GetSize(extraction.outputs));
 
-        delete output_nets_hash;
         return odin_netlist;
     }
 
@@ -737,6 +769,7 @@ struct ParMYSPass : public Pass {
     static void elaborate(netlist_t *odin_netlist)
     {
         double elaboration_time = wall_time();
+        profile_begin("elaborate");
 
         /* Perform any initialization routines here */
         find_hard_multipliers();
@@ -744,8 +777,11 @@ struct ParMYSPass : public Pass {
         // find_hard_adders_for_sub();
         register_hard_blocks();
 
+        profile_begin("resolve_top");
         resolve_top(odin_netlist);
+        profile_end(odin_netlist);
 
+        profile_end(odin_netlist);
         elaboration_time = wall_time() - elaboration_time;
         log("\nElaboration Time: ");
         log_time(elaboration_time);
@@ -755,6 +791,7 @@ struct ParMYSPass : public Pass {
     static void optimization(netlist_t *odin_netlist)
     {
         double optimization_time = wall_time();
+        profile_begin("optimization");
 
         if (odin_netlist) {
             check_netlist(odin_netlist);
@@ -763,36 +800,56 @@ struct ParMYSPass : public Pass {
             log("Performing Optimization on the Netlist\n");
             if (hard_multipliers) {
                 /* Perform a splitting of the multipliers for hard block mults */
+                profile_begin("reduce_operations(MULTIPLY)");
                 reduce_operations(odin_netlist, MULTIPLY);
+                profile_end(odin_netlist);
+
+                profile_begin("iterate_multipliers");
                 iterate_multipliers(odin_netlist);
                 clean_multipliers();
+                profile_end(odin_netlist);
             }
 
             if (block_memories_info.read_only_memory_list || block_memories_info.block_memory_list) {
                 /* Perform a hard block registration and splitting in width for Yosys generated memory blocks */
+                profile_begin("iterate_block_memories");
                 iterate_block_memories(odin_netlist);
                 free_block_memories();
+                profile_end(odin_netlist);
             }
 
             if (single_port_rams || dual_port_rams) {
                 /* Perform a splitting of any hard block memories */
+                profile_begin("iterate_memories");
                 iterate_memories(odin_netlist);
                 free_memory_lists();
+                profile_end(odin_netlist);
             }
 
             if (hard_adders) {
                 /* Perform a splitting of the adders for hard block add */
+                profile_begin("reduce_operations(ADD)");
                 reduce_operations(odin_netlist, ADD);
+                profile_end(odin_netlist);
+
+                profile_begin("iterate_adders");
                 iterate_adders(odin_netlist);
                 clean_adders();
+                profile_end(odin_netlist);
 
                 /* Perform a splitting of the adders for hard block sub */
+                profile_begin("reduce_operations(MINUS)");
                 reduce_operations(odin_netlist, MINUS);
+                profile_end(odin_netlist);
+
+                profile_begin("iterate_adders_for_sub");
                 iterate_adders_for_sub(odin_netlist);
                 clean_adders_for_sub();
+                profile_end(odin_netlist);
             }
         }
 
+        profile_end(odin_netlist);
         optimization_time = wall_time() - optimization_time;
         log("\nOptimization Time: ");
         log_time(optimization_time);
@@ -802,17 +859,26 @@ struct ParMYSPass : public Pass {
     static void techmap(netlist_t *odin_netlist)
     {
         double techmap_time = wall_time();
+        profile_begin("techmap");
 
         if (odin_netlist) {
             /* point where we convert netlist to FPGA or other hardware target compatible format */
             log("Performing Partial Technology Mapping to the target device\n");
+            profile_begin("partial_map_top");
             partial_map_top(odin_netlist);
+            profile_end(odin_netlist);
+
+            profile_begin("mixer optimizations");
             mixer->perform_optimizations(odin_netlist);
+            profile_end(odin_netlist);
 
             /* Find any unused logic in the netlist and remove it */
+            profile_begin("remove_unused_logic");
             remove_unused_logic(odin_netlist);
+            profile_end(odin_netlist);
         }
 
+        profile_end(odin_netlist);
         techmap_time = wall_time() - techmap_time;
         log("\nTechmap Time: ");
         log_time(techmap_time);
@@ -851,10 +917,59 @@ struct ParMYSPass : public Pass {
         log("        No additional passes will be executed.\n");
         log("\n");
         log("    -exact_mults int_value\n");
-        log("        To enable mixing hard block and soft logic implementation of adders\n");
+        log("        To enable mixing hard block and soft logic implementation of multipliers, with at most int_value hard\n");
+        log("        multiplier blocks (a multiplier wider than the block takes one per fragment it is split into). The\n");
+        log("        multipliers saving the most soft logic per block, weighted by their depth, are hardened first\n");
         log("\n");
         log("    -mults_ratio float_value\n");
-        log("        To enable mixing hard block and soft logic implementation of adders\n");
+        log("        To enable mixing hard block and soft logic implementation of multipliers, with float_value times the\n");
+        log("        hard multiplier blocks the design would need\n");
+        log("\n");
+        log("    -device layout_name\n");
+        log("        fixed layout of the architecture the design targets. Its hard multipliers, memories and adders bound\n");
+        log("        the hard blocks used: when multipliers exceed the device, the ones saving the least soft logic are\n");
+        log("        built in soft logic (unless -exact_mults or -mults_ratio is given). An architecture with a single\n");
+        log("        fixed layout uses it by default\n");
+        log("\n");
+        log("    -grid WIDTHxHEIGHT\n");
+        log("        size of the grid to build the auto layout of the architecture at, instead of -device\n");
+        log("\n");
+        log("    -profile\n");
+        log("        report wall time, cpu time, peak rss growth and netlist size of each phase as a table and as JSON\n");
+        log("\n");
+        log("    -profile_json json_file\n");
+        log("        same as -profile, the JSON report is also written to json_file\n");
+        log("\n");
+        log("    -partial\n");
+        log("        only hand the adders, multipliers, memories and hard blocks of the top module to odin, all other cells\n");
+        log("        are left in place as they are\n");
+        log("\n");
+        log("    -soft_mult array|tree|booth|auto\n");
+        log("        architecture of the multipliers built in soft logic: ripple adder array, Dadda tree with a single final\n");
+        log("        adder, radix-4 Booth rows summed by a Dadda tree for signed multipliers (tree for unsigned ones), or\n");
+        log("        auto: Booth for signed multipliers, array or tree picked from estimated LUT count and depth for unsigned\n");
+        log("        ones. tree, booth and auto are experimental, their estimates are not yet checked against mapped\n");
+        log("        results (default: array)\n");
+        log("\n");
+        log("    -const_mult_adders int_value\n");
+        log("        with hard multipliers in the architecture, multiplications by a constant needing at most this many\n");
+        log("        adders once recoded into signed digits are built as shift-and-add logic instead (default: 2). Without\n");
+        log("        hard multipliers every constant multiplication is built that way. Multiplications of the same signal by\n");
+        log("        different constants share one adder graph and are budgeted together, this many adders per multiplier\n");
+        log("\n");
+        log("    -read_ports mux|replicate|auto\n");
+        log("        mapping of memories with more than two read ports: mux the reads onto a single memory, replicate the\n");
+        log("        memory into dual port rams (two read ports per copy for roms, one per copy with the writes broadcast\n");
+        log("        otherwise), or auto: replicate when the extra rams, each costed as -bram_lut_cost LUTs, take no more\n");
+        log("        than the LUTs of the read muxes saved and the copies fit the device (default: auto)\n");
+        log("\n");
+        log("    -bram_lut_cost int_value\n");
+        log("        number of LUTs one block ram is worth for -read_ports auto (default: 100, about the area of a\n");
+        log("        32Kb memory tile over that of a LUT in the k6_frac_N10_mem32K architectures)\n");
+        log("\n");
+        log("    -nogroup\n");
+        log("        emit the soft logic one cell per netlist node instead of grouping ripple adders and mux banks\n");
+        log("        into wide cells\n");
         log("\n");
         log("    -vtr_prim\n");
         log("        loads vtr primitives as modules, if the design uses vtr prmitives then this flag is mandatory for first run\n");
@@ -866,13 +981,23 @@ struct ParMYSPass : public Pass {
         bool flag_config_file = false;
         bool flag_load_vtr_primitives = false;
         bool flag_no_pass = false;
+        bool flag_profile = false;
+        bool flag_partial = false;
+        std::string profile_json_path;
         std::string arch_file_path;
         std::string config_file_path;
         std::string top_module_name;
+        std::string device_name;
+        int grid_width = -1, grid_height = -1;
         std::string DEFAULT_OUTPUT(".");
 
         global_args.exact_mults.set(-1, argparse::Provenance::DEFAULT);
         global_args.mults_ratio.set(-1.0, argparse::Provenance::DEFAULT);
+        global_args.group_soft_logic.set(true, argparse::Provenance::DEFAULT);
+        global_args.soft_multiplier.set("array", argparse::Provenance::DEFAULT);
+        global_args.const_mult_adders.set(2, argparse::Provenance::DEFAULT);
+        global_args.read_port_mapping.set("auto", argparse::Provenance::DEFAULT);
+        global_args.bram_lut_cost.set(100, argparse::Provenance::DEFAULT);
 
         log_header(design, "Starting parmys pass.\n");
 
@@ -908,9 +1033,60 @@ struct ParMYSPass : public Pass {
                 global_args.mults_ratio.set(atof(args[++argidx].c_str()), argparse::Provenance::SPECIFIED);
                 continue;
             }
+            if (args[argidx] == "-profile") {
+                flag_profile = true;
+                continue;
+            }
+            if (args[argidx] == "-profile_json" && argidx + 1 < args.size()) {
+                profile_json_path = args[++argidx];
+                flag_profile = true;
+                continue;
+            }
+            if (args[argidx] == "-partial") {
+                flag_partial = true;
+                continue;
+            }
+            if (args[argidx] == "-soft_mult" && argidx + 1 < args.size()) {
+                std::string arch = args[++argidx];
+                if (arch != "array" && arch != "tree" && arch != "booth" && arch != "auto")
+                    log_cmd_error("Unknown soft multiplier architecture %s, expected array, tree, booth or auto.\n", arch.c_str());
+                global_args.soft_multiplier.set(arch, argparse::Provenance::SPECIFIED);
+                continue;
+            }
+            if (args[argidx] == "-read_ports" && argidx + 1 < args.size()) {
+                std::string mapping = args[++argidx];
+                if (mapping != "mux" && mapping != "replicate" && mapping != "auto")
+                    log_cmd_error("Unknown read port mapping %s, expected mux, replicate or auto.\n", mapping.c_str());
+                global_args.read_port_mapping.set(mapping, argparse::Provenance::SPECIFIED);
+                continue;
+            }
+            if (args[argidx] == "-bram_lut_cost" && argidx + 1 < args.size()) {
+                global_args.bram_lut_cost.set(atoi(args[++argidx].c_str()), argparse::Provenance::SPECIFIED);
+                continue;
+            }
+            if (args[argidx] == "-const_mult_adders" && argidx + 1 < args.size()) {
+                global_args.const_mult_adders.set(atoi(args[++argidx].c_str()), argparse::Provenance::SPECIFIED);
+                continue;
+            }
+            if (args[argidx] == "-device" && argidx + 1 < args.size()) {
+                device_name = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-grid" && argidx + 1 < args.size()) {
+                std::string grid = args[++argidx];
+                if (sscanf(grid.c_str(), "%dx%d", &grid_width, &grid_height) != 2 || grid_width <= 0 || grid_height <= 0)
+                    log_cmd_error("Invalid grid size %s, expected WIDTHxHEIGHT.\n", grid.c_str());
+                continue;
+            }
+            if (args[argidx] == "-nogroup") {
+                global_args.group_soft_logic.set(false, argparse::Provenance::SPECIFIED);
+                continue;
+            }
         }
         extra_args(args, argidx, design);
 
+        profile_enable(flag_profile);
+
         std::vector<t_physical_tile_type> physical_tile_types;
         std::vector<t_logical_block_type> logical_block_types;
 
@@ -927,6 +1103,9 @@ struct ParMYSPass : public Pass {
         mixer = new HardSoftLogicMixer();
         set_default_config();
 
+        /* the capacity of the device is only known when this run reads the architecture */
+        hard_block_capacity = hard_block_capacity_t();
+
         if (global_args.mults_ratio >= 0.0 && global_args.mults_ratio <= 1.0) {
             delete mixer->_opts[MULTIPLY];
             mixer->_opts[MULTIPLY] = new MultsOpt(global_args.mults_ratio);
@@ -954,10 +1133,19 @@ struct ParMYSPass : public Pass {
             try {
                 XmlReadArch(arch_file_path.c_str(), false, &Arch, physical_tile_types, logical_block_types);
                 set_physical_lut_size(logical_block_types);
+                collect_memory_modes(logical_block_types);
             } catch (vtr::VtrError &vtr_error) {
                 log_error("Odin Failed to load architecture file: %s with exit code%d at line: %ld\n", vtr_error.what(), ERROR_PARSE_ARCH,
                           vtr_error.line());
             }
+
+            compute_hard_block_capacity(Arch, physical_tile_types, device_name, grid_width, grid_height);
+
+            /* without a budget of its own, the mixer keeps the multipliers within the device */
+            if (hard_block_capacity.multipliers >= 0 && !mixer->_opts[MULTIPLY]->enabled()) {
+                delete mixer->_opts[MULTIPLY];
+                mixer->_opts[MULTIPLY] = new MultsOpt(1.0f);
+            }
         }
         log("Using Lut input width of: %d\n", physical_lut_size);
 
@@ -999,41 +1187,14 @@ struct ParMYSPass : public Pass {
         log("--------------------------------------------------------------------\n");
         log("Creating Odin-II Netlist from Design\n");
 
-        std::vector<Bbox> black_boxes;
-
-        for (auto bb_module : design->modules()) {
-            if (bb_module->get_bool_attribute(ID::blackbox)) {
+        extraction_t extraction;
 
-                Bbox bb;
+        /* an error before free_netlist must not leave the netlist arena active for the next run */
+        netlist_arena_guard arena_guard;
 
-                bb.name = str(bb_module->name);
-
-                std::map<int, Yosys::RTLIL::Wire *> inputs, outputs;
-
-                for (auto wire : bb_module->wires()) {
-                    if (wire->port_input)
-                        inputs[wire->port_id] = wire;
-                    if (wire->port_output)
-                        outputs[wire->port_id] = wire;
-                }
-
-                for (auto &it : inputs) {
-                    Yosys::RTLIL::Wire *wire = it.second;
-                    for (int i = 0; i < wire->width; i++)
-                        bb.inputs.push_back(str(Yosys::RTLIL::SigSpec(wire, i)));
-                }
-
-                for (auto &it : outputs) {
-                    Yosys::RTLIL::Wire *wire = it.second;
-                    for (int i = 0; i < wire->width; i++)
-                        bb.outputs.push_back(str(Yosys::RTLIL::SigSpec(wire, i)));
-                }
-
-                black_boxes.push_back(bb);
-            }
-        }
-
-        netlist_t *transformed = to_netlist(design->top_module(), design);
+        profile_begin("to_netlist");
+        netlist_t *transformed = to_netlist(design->top_module(), design, flag_partial, extraction);
+        profile_end(transformed);
 
         double synthesis_time = wall_time();
 
@@ -1071,53 +1232,11 @@ struct ParMYSPass : public Pass {
         log("\n--------------------------------------------------------------------\n");
 
         log("Updating the Design\n");
-        Pass::call(design, "delete");
-
-        for (auto module : design->modules()) {
-            design->remove(module);
-        }
-
-        for (auto bb_module : black_boxes) {
-            Yosys::Module *module = nullptr;
-            Yosys::hashlib::dict<Yosys::IdString, std::pair<int, bool>> wideports_cache;
-
-            module = new Yosys::Module;
-            module->name = RTLIL::escape_id(bb_module.name);
-
-            if (design->module(module->name))
-                log_error("Duplicate definition of module %s!\n", Yosys::log_id(module->name));
+        profile_begin("update_design");
+        update_design(design, transformed, extraction);
+        profile_end(transformed);
 
-            design->add(module);
-
-            for (auto b_wire : bb_module.inputs) {
-                Yosys::RTLIL::Wire *wire = to_wire(b_wire, module);
-                wire->port_input = true;
-                std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(Yosys::RTLIL::unescape_id(b_wire));
-                if (!wp.first.empty() && wp.second >= 0) {
-                    wideports_cache[wp.first].first = std::max(wideports_cache[wp.first].first, wp.second + 1);
-                    wideports_cache[wp.first].second = true;
-                }
-            }
-
-            for (auto b_wire : bb_module.outputs) {
-                Yosys::RTLIL::Wire *wire = to_wire(Yosys::RTLIL::unescape_id(b_wire), module);
-                wire->port_output = true;
-                std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(Yosys::RTLIL::unescape_id(b_wire));
-                if (!wp.first.empty() && wp.second >= 0) {
-                    wideports_cache[wp.first].first = std::max(wideports_cache[wp.first].first, wp.second + 1);
-                    wideports_cache[wp.first].second = false;
-                }
-            }
-
-            handle_wideports_cache(&wideports_cache, module);
-
-            module->fixup_ports();
-            wideports_cache.clear();
-
-            module->attributes[Yosys::ID::blackbox] = Yosys::RTLIL::Const(1);
-        }
-
-        update_design(design, transformed);
+        profile_report(profile_json_path);
 
         if (!flag_no_pass) {
             if (top_module_name.empty()) {
@@ -1127,6 +1246,9 @@ struct ParMYSPass : public Pass {
             }
         }
 
+        if (design->top_module())
+            check_hard_block_usage(design->top_module());
+
         log("--------------------------------------------------------------------\n");
 
         free_netlist(transformed);
@@ -0,0 +1,348 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @file This file computes the hard blocks (multipliers, memories
+ * and adders) of the target device. The grid of the chosen layout
+ * is built the way VPR builds it, from the location specifications
+ * of the architecture, and the primitives of every placed tile are
+ * counted.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <string.h>
+
+#include "kernel/yosys.h"
+
+#include "odin_types.h"
+#include "parmys_capacity.hpp"
+#include "vtr_expr_eval.h"
+
+USING_YOSYS_NAMESPACE
+
+hard_block_capacity_t hard_block_capacity;
+
+/*---------------------------------------------------------------------------------------------
+ * (function: find_model)
+ *-------------------------------------------------------------------------------------------*/
+static const t_model *find_model(const t_arch &arch, const char *name)
+{
+    for (const t_model *model = arch.models; model != NULL; model = model->next) {
+        if (!strcmp(model->name, name))
+            return model;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: is_primitive_of)
+ * 	whether the pb_type is a primitive of the model, blif_model reads ".subckt <model>"
+ *-------------------------------------------------------------------------------------------*/
+static bool is_primitive_of(const t_pb_type *pb_type, const char *model_name)
+{
+    if (pb_type->num_modes != 0)
+        return false;
+
+    if (pb_type->model)
+        return !strcmp(pb_type->model->name, model_name);
+
+    if (pb_type->blif_model) {
+        const char *name = strrchr(pb_type->blif_model, ' ');
+        return name && !strcmp(name + 1, model_name);
+    }
+
+    return false;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: widest_input)
+ * 	the widest data input port of a primitive
+ *-------------------------------------------------------------------------------------------*/
+static int widest_input(const t_pb_type *pb_type)
+{
+    int width = 0;
+    for (int i = 0; i < pb_type->num_ports; i++) {
+        if (pb_type->ports[i].type == IN_PORT && !pb_type->ports[i].is_clock)
+            width = std::max(width, pb_type->ports[i].num_pins);
+    }
+    return width;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: count_primitives)
+ * 	the most primitives accepted by is_counted the pb_type holds at once, in any of its modes
+ *-------------------------------------------------------------------------------------------*/
+template <typename Counted> static long count_primitives(const t_pb_type *pb_type, Counted is_counted)
+{
+    if (pb_type->num_modes == 0)
+        return is_counted(pb_type) ? 1 : 0;
+
+    long most = 0;
+    for (int i = 0; i < pb_type->num_modes; i++) {
+        const t_mode &mode = pb_type->modes[i];
+
+        long count = 0;
+        for (int j = 0; j < mode.num_pb_type_children; j++)
+            count += mode.pb_type_children[j].num_pb * count_primitives(&mode.pb_type_children[j], is_counted);
+
+        most = std::max(most, count);
+    }
+
+    return most;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: count_tile_primitives)
+ * 	primitives of one tile: every sub tile instance takes the equivalent site holding the most
+ *-------------------------------------------------------------------------------------------*/
+template <typename Counted> static long count_tile_primitives(const t_physical_tile_type &tile, Counted is_counted)
+{
+    long count = 0;
+    for (const t_sub_tile &sub_tile : tile.sub_tiles) {
+        long per_instance = 0;
+        for (t_logical_block_type_ptr site : sub_tile.equivalent_sites) {
+            if (site && site->pb_type)
+                per_instance = std::max(per_instance, count_primitives(site->pb_type, is_counted));
+        }
+        count += sub_tile.capacity.total() * per_instance;
+    }
+    return count;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: place_tile)
+ * 	places a tile rooted at (x, y) unless a cell it covers holds a tile of higher priority.
+ * 	Tiles it overlaps are removed, as VPR does.
+ *-------------------------------------------------------------------------------------------*/
+static void place_tile(std::vector<int> &root, std::vector<int> &type, std::vector<int> &priority, int grid_width, int grid_height,
+                       const std::vector<t_physical_tile_type> &tiles, int tile, int tile_priority, int x, int y)
+{
+    int width = std::max(1, tiles[tile].width);
+    int height = std::max(1, tiles[tile].height);
+    if (x < 0 || y < 0 || x + width > grid_width || y + height > grid_height)
+        return;
+
+    for (int i = x; i < x + width; i++)
+        for (int j = y; j < y + height; j++)
+            if (priority[i * grid_height + j] > tile_priority)
+                return;
+
+    for (int i = x; i < x + width; i++) {
+        for (int j = y; j < y + height; j++) {
+            int old_root = root[i * grid_height + j];
+            if (old_root < 0)
+                continue;
+
+            /* clear the whole tile that was there */
+            int old_x = old_root / grid_height;
+            int old_y = old_root % grid_height;
+            int old_type = type[old_root];
+            for (int k = old_x; k < old_x + std::max(1, tiles[old_type].width) && k < grid_width; k++) {
+                for (int l = old_y; l < old_y + std::max(1, tiles[old_type].height) && l < grid_height; l++) {
+                    if (root[k * grid_height + l] == old_root) {
+                        root[k * grid_height + l] = -1;
+                        type[k * grid_height + l] = -1;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = x; i < x + width; i++) {
+        for (int j = y; j < y + height; j++) {
+            root[i * grid_height + j] = x * grid_height + y;
+            type[i * grid_height + j] = tile;
+            priority[i * grid_height + j] = tile_priority;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: count_grid_tiles)
+ * 	builds the grid of the layout and returns the number of tiles of every physical tile type
+ *-------------------------------------------------------------------------------------------*/
+static std::vector<long> count_grid_tiles(const t_grid_def &layout, const std::vector<t_physical_tile_type> &tiles, int grid_width, int grid_height)
+{
+    std::vector<int> root(grid_width * grid_height, -1);
+    std::vector<int> type(grid_width * grid_height, -1);
+    std::vector<int> priority(grid_width * grid_height, INT_MIN);
+
+    /* lower priorities first, the ones placed later win ties */
+    std::vector<const t_grid_loc_def *> loc_defs;
+    for (const t_grid_loc_def &loc_def : layout.loc_defs)
+        loc_defs.push_back(&loc_def);
+    std::stable_sort(loc_defs.begin(), loc_defs.end(), [](const t_grid_loc_def *a, const t_grid_loc_def *b) { return a->priority < b->priority; });
+
+    vtr::FormulaParser parser;
+    vtr::t_formula_data vars;
+    vars.set_var_value("W", grid_width);
+    vars.set_var_value("H", grid_height);
+
+    for (const t_grid_loc_def *loc_def : loc_defs) {
+        int tile = -1;
+        for (size_t i = 0; i < tiles.size(); i++) {
+            if (tiles[i].name && loc_def->block_type == tiles[i].name)
+                tile = i;
+        }
+
+        if (tile < 0) {
+            log_warning("Layout %s places unknown block type %s, it is not counted.\n", layout.name.c_str(), loc_def->block_type.c_str());
+            continue;
+        }
+
+        vars.set_var_value("w", std::max(1, tiles[tile].width));
+        vars.set_var_value("h", std::max(1, tiles[tile].height));
+
+        int start_x = parser.parse_formula(loc_def->x.start_expr, vars);
+        int end_x = parser.parse_formula(loc_def->x.end_expr, vars);
+        int incr_x = std::max(1, parser.parse_formula(loc_def->x.incr_expr, vars));
+        int repeat_x = std::max(1, parser.parse_formula(loc_def->x.repeat_expr, vars));
+        int start_y = parser.parse_formula(loc_def->y.start_expr, vars);
+        int end_y = parser.parse_formula(loc_def->y.end_expr, vars);
+        int incr_y = std::max(1, parser.parse_formula(loc_def->y.incr_expr, vars));
+        int repeat_y = std::max(1, parser.parse_formula(loc_def->y.repeat_expr, vars));
+
+        if (end_x < start_x || end_y < start_y)
+            continue;
+
+        /* the region [start, end] is repeated every repeat cells until the edge of the grid */
+        for (int region_x = start_x; region_x < grid_width; region_x += repeat_x) {
+            for (int region_y = start_y; region_y < grid_height; region_y += repeat_y) {
+                for (int x = region_x; x <= region_x + (end_x - start_x) && x < grid_width; x += incr_x)
+                    for (int y = region_y; y <= region_y + (end_y - start_y) && y < grid_height; y += incr_y)
+                        place_tile(root, type, priority, grid_width, grid_height, tiles, tile, loc_def->priority, x, y);
+            }
+        }
+    }
+
+    std::vector<long> counts(tiles.size(), 0);
+    for (int cell = 0; cell < grid_width * grid_height; cell++) {
+        if (root[cell] == cell)
+            counts[type[cell]]++;
+    }
+
+    return counts;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: compute_hard_block_capacity)
+ * 	fills hard_block_capacity from the layout of the architecture: the fixed layout named
+ * 	device, the only layout if it is fixed, or an auto layout sized grid_width x grid_height.
+ * 	Without any of them the device size is unknown and the capacity is left at -1.
+ *-------------------------------------------------------------------------------------------*/
+void compute_hard_block_capacity(const t_arch &arch, const std::vector<t_physical_tile_type> &physical_tile_types, const std::string &device,
+                                 int grid_width, int grid_height)
+{
+    hard_block_capacity = hard_block_capacity_t();
+
+    const t_grid_def *layout = NULL;
+    if (!device.empty()) {
+        for (const t_grid_def &grid_layout : arch.grid_layouts) {
+            if (grid_layout.name == device)
+                layout = &grid_layout;
+        }
+        if (layout == NULL)
+            log_error("The architecture has no layout named %s.\n", device.c_str());
+    } else if (arch.grid_layouts.size() == 1 && arch.grid_layouts[0].grid_type == GridDefType::FIXED) {
+        layout = &arch.grid_layouts[0];
+    } else if (grid_width > 0 && grid_height > 0) {
+        for (const t_grid_def &grid_layout : arch.grid_layouts) {
+            if (grid_layout.grid_type == GridDefType::AUTO && layout == NULL)
+                layout = &grid_layout;
+        }
+        if (layout == NULL)
+            log_error("The architecture has no auto layout to size to %dx%d, use -device to pick a fixed layout.\n", grid_width, grid_height);
+    }
+
+    if (layout == NULL)
+        return;
+
+    if (layout->grid_type == GridDefType::FIXED) {
+        if (grid_width > 0)
+            log_warning("Layout %s has a fixed size, -grid is ignored.\n", layout->name.c_str());
+        grid_width = layout->width;
+        grid_height = layout->height;
+    } else if (grid_width <= 0 || grid_height <= 0) {
+        /* an auto layout grows with the design, nothing to bound it with */
+        return;
+    }
+
+    std::vector<long> tile_counts = count_grid_tiles(*layout, physical_tile_types, grid_width, grid_height);
+
+    const t_model *multiply = find_model(arch, "multiply");
+    int multiply_width = 0;
+    for (const t_model_ports *port = (multiply) ? multiply->inputs : NULL; port != NULL; port = port->next)
+        multiply_width = std::max(multiply_width, port->size);
+
+    hard_block_capacity.multipliers = (multiply) ? 0 : -1;
+    hard_block_capacity.memories = 0;
+    hard_block_capacity.adders = 0;
+    for (size_t i = 0; i < physical_tile_types.size(); i++) {
+        if (tile_counts[i] == 0)
+            continue;
+
+        const t_physical_tile_type &tile = physical_tile_types[i];
+        if (multiply) {
+            /* fracturable DSPs are counted in full size multipliers, the unit the mixer budgets in */
+            hard_block_capacity.multipliers += tile_counts[i] * count_tile_primitives(tile, [multiply_width](const t_pb_type *pb_type) {
+                                                   return is_primitive_of(pb_type, "multiply") && widest_input(pb_type) >= multiply_width;
+                                               });
+        }
+        hard_block_capacity.memories += tile_counts[i] * count_tile_primitives(tile, [](const t_pb_type *pb_type) {
+                                            return is_primitive_of(pb_type, SINGLE_PORT_RAM_string) || is_primitive_of(pb_type, DUAL_PORT_RAM_string);
+                                        });
+        hard_block_capacity.adders += tile_counts[i] * count_tile_primitives(tile, [](const t_pb_type *pb_type) { return is_primitive_of(pb_type, "adder"); });
+    }
+
+    log("Device %s (%dx%d): %ld hard multipliers, %ld memory blocks, %ld adder bits\n", layout->name.c_str(), grid_width, grid_height,
+        hard_block_capacity.multipliers, hard_block_capacity.memories, hard_block_capacity.adders);
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: check_hard_block_usage)
+ * 	warns about hard blocks of the mapped module exceeding the device, which VPR would
+ * 	only report once it fails to place them
+ *-------------------------------------------------------------------------------------------*/
+void check_hard_block_usage(Module *module)
+{
+    IdString multiply_id = RTLIL::escape_id("multiply");
+    IdString single_port_ram_id = RTLIL::escape_id(SINGLE_PORT_RAM_string);
+    IdString dual_port_ram_id = RTLIL::escape_id(DUAL_PORT_RAM_string);
+    IdString adder_id = RTLIL::escape_id("adder");
+
+    long multipliers = 0, memories = 0, adders = 0;
+    for (auto cell : module->cells()) {
+        if (cell->type == multiply_id)
+            multipliers++;
+        else if (cell->type == single_port_ram_id || cell->type == dual_port_ram_id)
+            memories++;
+        else if (cell->type == adder_id)
+            adders++;
+    }
+
+    if (hard_block_capacity.multipliers >= 0 && multipliers > hard_block_capacity.multipliers)
+        log_warning("The design uses %ld hard multipliers, the device has %ld.\n", multipliers, hard_block_capacity.multipliers);
+    if (hard_block_capacity.memories >= 0 && memories > hard_block_capacity.memories)
+        log_warning("The design uses %ld memory blocks, the device has %ld.\n", memories, hard_block_capacity.memories);
+    if (hard_block_capacity.adders >= 0 && adders > hard_block_capacity.adders)
+        log_warning("The design uses %ld adder bits, the device has %ld.\n", adders, hard_block_capacity.adders);
+}
@@ -0,0 +1,48 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __PARMYS_CAPACITY_H__
+#define __PARMYS_CAPACITY_H__
+
+#include <string>
+#include <vector>
+
+#include "odin_types.h"
+#include "physical_types.h"
+
+#include "kernel/rtlil.h"
+
+/* hard blocks the target device offers, -1 when the size of the device is not known */
+struct hard_block_capacity_t {
+    long multipliers = -1; // full size hard multipliers
+    long memories = -1;    // single_port_ram/dual_port_ram blocks
+    long adders = -1;      // adder primitives (bits of the carry chains)
+};
+
+extern hard_block_capacity_t hard_block_capacity;
+
+void compute_hard_block_capacity(const t_arch &arch, const std::vector<t_physical_tile_type> &physical_tile_types, const std::string &device,
+                                 int grid_width, int grid_height);
+void check_hard_block_usage(Yosys::Module *module);
+
+#endif //__PARMYS_CAPACITY_H__
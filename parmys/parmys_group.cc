@@ -0,0 +1,388 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @file This file regroups the bit sliced soft logic of the mapped
+ * netlist before it is written back to the module: the ripple
+ * adders built by instantiate_add_w_carry_block become one $alu
+ * each, and MUX_2 nodes sharing their selectors become one word
+ * wide and/or tree. Small muxes left alone become a single $lut.
+ * Every node handled here is added to grouped, so update_design
+ * skips it when it emits the remaining nodes one by one.
+ */
+
+#include <map>
+#include <vector>
+
+#include "odin_globals.h"
+#include "odin_types.h"
+
+#include "netlist_traversal.h"
+
+#include "kernel/yosys.h"
+
+#include "parmys_group.hpp"
+#include "parmys_utils.hpp"
+
+/* chains shorter than this are left as single cells */
+#define MIN_GROUPED_ADDER_WIDTH 2
+
+struct group_stats_t {
+    int adder_chains;
+    int adder_bits;
+    int mux_banks;
+    int banked_muxes;
+    int mux_luts;
+};
+
+static bool is_single_output_gate(nnode_t *node, operation_list type, int num_input_pins);
+static nnode_t *find_sibling(nnode_t *node, operation_list type, const Yosys::hashlib::pool<nnode_t *> &grouped);
+static Yosys::SigSpec claim_output_sig(Yosys::Module *module, const std::vector<nnet_t *> &nets);
+static void group_adder_chain(Yosys::Module *module, nnode_t *head, Yosys::hashlib::pool<nnode_t *> &grouped, group_stats_t &stats);
+static void group_mux_bank(Yosys::Module *module, const std::vector<nnode_t *> &bank, Yosys::hashlib::pool<nnode_t *> &grouped, group_stats_t &stats);
+static void mux_to_lut(Yosys::Module *module, nnode_t *node, Yosys::hashlib::pool<nnode_t *> &grouped, group_stats_t &stats);
+
+/*---------------------------------------------------------------------------------------------
+ * (function: group_soft_logic)
+ * 	Emits the adder chains and mux banks of netlist as wide cells of module, the nodes they
+ * 	cover are added to grouped
+ *-------------------------------------------------------------------------------------------*/
+void group_soft_logic(Yosys::Module *module, netlist_t *netlist, Yosys::hashlib::pool<nnode_t *> &grouped)
+{
+    std::vector<nnode_t *> carries;
+    std::vector<nnode_t *> muxes;
+
+    auto collect = [&](nnode_t *node) {
+        if (is_single_output_gate(node, CARRY_FUNC, 3))
+            carries.push_back(node);
+        else if (is_single_output_gate(node, MUX_2, node->num_input_pins) && node->num_input_port_sizes == 2 &&
+                 node->input_port_sizes[0] == node->input_port_sizes[1] && node->num_input_pins == 2 * node->input_port_sizes[0])
+            muxes.push_back(node);
+    };
+
+    walk_fanout_post_order(netlist->gnd_node, GROUP_SOFT_LOGIC_VALUE, collect);
+    walk_fanout_post_order(netlist->vcc_node, GROUP_SOFT_LOGIC_VALUE, collect);
+    walk_fanout_post_order(netlist->pad_node, GROUP_SOFT_LOGIC_VALUE, collect);
+    for (long i = 0; i < netlist->num_top_input_nodes; i++)
+        walk_fanout_post_order(netlist->top_input_nodes[i], GROUP_SOFT_LOGIC_VALUE, collect);
+
+    group_stats_t stats = {0, 0, 0, 0, 0};
+
+    /* ripple adders, walked from the carry of their lowest full adder */
+    for (nnode_t *carry : carries) {
+        if (grouped.count(carry) || !find_sibling(carry, ADDER_FUNC, grouped))
+            continue;
+
+        nnet_t *carry_in = carry->input_pins[0]->net;
+        nnode_t *driver = (carry_in->num_driver_pins) ? carry_in->driver_pins[0]->node : NULL;
+        if (driver && is_single_output_gate(driver, CARRY_FUNC, 3) && find_sibling(driver, ADDER_FUNC, grouped))
+            continue;
+
+        group_adder_chain(module, carry, grouped, stats);
+    }
+
+    /* mux banks, muxes reading the same selectors in the same order */
+    std::map<std::vector<nnet_t *>, size_t> bank_index;
+    std::vector<std::vector<nnode_t *>> banks;
+    for (nnode_t *mux : muxes) {
+        std::vector<nnet_t *> selectors;
+        for (int i = 0; i < mux->input_port_sizes[0]; i++)
+            selectors.push_back(mux->input_pins[i]->net);
+
+        auto found = bank_index.find(selectors);
+        if (found == bank_index.end()) {
+            bank_index[selectors] = banks.size();
+            banks.push_back({mux});
+        } else {
+            banks[found->second].push_back(mux);
+        }
+    }
+
+    for (auto &bank : banks)
+        group_mux_bank(module, bank, grouped, stats);
+
+    Yosys::log("Grouped %d adder chains (%d bits), %d mux banks (%d muxes) and %d muxes as LUTs.\n", stats.adder_chains, stats.adder_bits,
+               stats.mux_banks, stats.banked_muxes, stats.mux_luts);
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: is_single_output_gate)
+ * 	True if node is of type, has num_input_pins connected inputs and a single output
+ *-------------------------------------------------------------------------------------------*/
+static bool is_single_output_gate(nnode_t *node, operation_list type, int num_input_pins)
+{
+    if (node->type != type || node->num_input_pins != num_input_pins || node->num_output_pins != 1)
+        return false;
+
+    for (int i = 0; i < num_input_pins; i++) {
+        if (node->input_pins[i] == NULL || node->input_pins[i]->net == NULL)
+            return false;
+    }
+
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: find_sibling)
+ * 	Returns the gate of type reading the very same nets as node, pin for pin, NULL if there
+ * 	is none. Only the input net of node with the fewest fanouts is searched.
+ *-------------------------------------------------------------------------------------------*/
+static nnode_t *find_sibling(nnode_t *node, operation_list type, const Yosys::hashlib::pool<nnode_t *> &grouped)
+{
+    nnet_t *narrowest = node->input_pins[0]->net;
+    for (int i = 1; i < node->num_input_pins; i++) {
+        if (node->input_pins[i]->net->num_fanout_pins < narrowest->num_fanout_pins)
+            narrowest = node->input_pins[i]->net;
+    }
+
+    for (int i = 0; i < narrowest->num_fanout_pins; i++) {
+        npin_t *pin = narrowest->fanout_pins[i];
+        nnode_t *other = (pin) ? pin->node : NULL;
+        if (other == NULL || other == node || grouped.count(other) || !is_single_output_gate(other, type, node->num_input_pins))
+            continue;
+
+        bool same_inputs = true;
+        for (int j = 0; j < node->num_input_pins && same_inputs; j++)
+            same_inputs = (other->input_pins[j]->net == node->input_pins[j]->net);
+
+        if (same_inputs)
+            return other;
+    }
+
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: claim_output_sig)
+ * 	Returns a fresh wire driving nets, nets resolved already are connected to it. A NULL net
+ * 	leaves its bit of the wire unused.
+ *-------------------------------------------------------------------------------------------*/
+static Yosys::SigSpec claim_output_sig(Yosys::Module *module, const std::vector<nnet_t *> &nets)
+{
+    Yosys::RTLIL::Wire *wire = module->addWire(NEW_ID, nets.size());
+
+    for (size_t i = 0; i < nets.size(); i++) {
+        nnet_t *net = nets[i];
+        if (net == NULL)
+            continue;
+
+        if (net->has_yosys_bit) {
+            module->connect(net->yosys_bit, Yosys::RTLIL::SigBit(wire, i));
+        } else {
+            net->yosys_bit = Yosys::RTLIL::SigBit(wire, i);
+            net->has_yosys_bit = true;
+        }
+    }
+
+    return wire;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: group_adder_chain)
+ * 	Walks the ripple adder starting with the full adder carry head up along its carries and
+ * 	emits it as one $alu. A half adder (xor/and, or xnor/or for a carry in of one) driving
+ * 	the carry in of head becomes the lowest bit of the $alu.
+ *-------------------------------------------------------------------------------------------*/
+static void group_adder_chain(Yosys::Module *module, nnode_t *head, Yosys::hashlib::pool<nnode_t *> &grouped, group_stats_t &stats)
+{
+    std::vector<nnode_t *> sums;
+    std::vector<nnode_t *> carries;
+    Yosys::RTLIL::SigBit carry_in;
+    bool has_carry_in = false;
+
+    /* the half adder of the lowest bit */
+    nnet_t *head_carry_in = head->input_pins[0]->net;
+    nnode_t *driver = (head_carry_in->num_driver_pins) ? head_carry_in->driver_pins[0]->node : NULL;
+    if (driver && !grouped.count(driver)) {
+        nnode_t *half_sum = NULL;
+        if (is_single_output_gate(driver, LOGICAL_AND, 2)) {
+            half_sum = find_sibling(driver, LOGICAL_XOR, grouped);
+            carry_in = Yosys::RTLIL::State::S0;
+        } else if (is_single_output_gate(driver, LOGICAL_OR, 2)) {
+            half_sum = find_sibling(driver, LOGICAL_XNOR, grouped);
+            carry_in = Yosys::RTLIL::State::S1;
+        }
+
+        if (half_sum) {
+            sums.push_back(half_sum);
+            carries.push_back(driver);
+            has_carry_in = true;
+        }
+    }
+
+    if (!has_carry_in)
+        carry_in = net_bit(module, head_carry_in);
+
+    for (nnode_t *node : sums)
+        grouped.insert(node);
+    for (nnode_t *node : carries)
+        grouped.insert(node);
+
+    nnode_t *carry = head;
+    while (carry) {
+        nnode_t *sum = find_sibling(carry, ADDER_FUNC, grouped);
+        oassert(sum);
+
+        sums.push_back(sum);
+        carries.push_back(carry);
+        grouped.insert(sum);
+        grouped.insert(carry);
+
+        /* the next full adder reads the carry out on its first pin */
+        nnet_t *carry_out = carry->output_pins[0]->net;
+        nnode_t *next_sum = NULL;
+        carry = NULL;
+
+        for (int i = 0; carry_out && i < carry_out->num_fanout_pins && !carry; i++) {
+            npin_t *pin = carry_out->fanout_pins[i];
+            nnode_t *other = (pin) ? pin->node : NULL;
+            if (other == NULL || grouped.count(other) || other->num_input_pins != 3 || other->input_pins[0]->net != carry_out)
+                continue;
+
+            if (is_single_output_gate(other, CARRY_FUNC, 3) && find_sibling(other, ADDER_FUNC, grouped))
+                carry = other;
+            else if (next_sum == NULL && is_single_output_gate(other, ADDER_FUNC, 3))
+                next_sum = other;
+        }
+
+        /* the top bit of a subtraction has no carry out */
+        if (carry == NULL && next_sum != NULL) {
+            sums.push_back(next_sum);
+            carries.push_back(NULL);
+            grouped.insert(next_sum);
+        }
+    }
+
+    int width = sums.size();
+    if (width < MIN_GROUPED_ADDER_WIDTH) {
+        for (nnode_t *node : sums)
+            grouped.erase(node);
+        for (nnode_t *node : carries)
+            grouped.erase(node);
+        return;
+    }
+
+    Yosys::RTLIL::SigSpec sig_a, sig_b;
+    std::vector<nnet_t *> sum_nets, carry_nets;
+    for (int i = 0; i < width; i++) {
+        /* the full adders read the carry in on their first pin */
+        int first = sums[i]->num_input_pins - 2;
+        sig_a.append(net_bit(module, sums[i]->input_pins[first]->net));
+        sig_b.append(net_bit(module, sums[i]->input_pins[first + 1]->net));
+
+        sum_nets.push_back(sums[i]->output_pins[0]->net);
+        carry_nets.push_back((carries[i]) ? carries[i]->output_pins[0]->net : NULL);
+    }
+
+    Yosys::RTLIL::Cell *cell = module->addCell(NEW_ID, ID($alu));
+    cell->setPort(Yosys::ID::A, sig_a);
+    cell->setPort(Yosys::ID::B, sig_b);
+    cell->setPort(Yosys::ID::CI, carry_in);
+    cell->setPort(Yosys::ID::BI, Yosys::RTLIL::State::S0);
+    cell->setPort(Yosys::ID::X, module->addWire(NEW_ID, width));
+    cell->setPort(Yosys::ID::Y, claim_output_sig(module, sum_nets));
+    cell->setPort(Yosys::ID::CO, claim_output_sig(module, carry_nets));
+    cell->parameters[Yosys::ID::A_SIGNED] = Yosys::RTLIL::Const(false);
+    cell->parameters[Yosys::ID::B_SIGNED] = Yosys::RTLIL::Const(false);
+    cell->parameters[Yosys::ID::A_WIDTH] = Yosys::RTLIL::Const(width);
+    cell->parameters[Yosys::ID::B_WIDTH] = Yosys::RTLIL::Const(width);
+    cell->parameters[Yosys::ID::Y_WIDTH] = Yosys::RTLIL::Const(width);
+
+    stats.adder_chains++;
+    stats.adder_bits += width;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: group_mux_bank)
+ * 	Emits the muxes of bank, which all read the same selectors, as one and/or tree over the
+ * 	whole word: one $and per selector and the $or chain summing them up. That is 2n - 1
+ * 	cells for n selectors instead of two per mux, banks where it does not pay off are
+ * 	handed to mux_to_lut mux by mux.
+ *-------------------------------------------------------------------------------------------*/
+static void group_mux_bank(Yosys::Module *module, const std::vector<nnode_t *> &bank, Yosys::hashlib::pool<nnode_t *> &grouped, group_stats_t &stats)
+{
+    int width = bank.size();
+    int num_selectors = bank[0]->input_port_sizes[0];
+
+    if (width < 2 || 2 * num_selectors - 1 >= 2 * width) {
+        for (nnode_t *mux : bank)
+            mux_to_lut(module, mux, grouped, stats);
+        return;
+    }
+
+    std::vector<nnet_t *> out_nets;
+    for (nnode_t *mux : bank) {
+        out_nets.push_back(mux->output_pins[0]->net);
+        grouped.insert(mux);
+    }
+
+    Yosys::RTLIL::SigSpec sig_y = claim_output_sig(module, out_nets);
+    Yosys::RTLIL::SigSpec sig_sum;
+
+    for (int j = 0; j < num_selectors; j++) {
+        Yosys::RTLIL::SigBit selector = net_bit(module, bank[0]->input_pins[j]->net);
+        Yosys::RTLIL::SigSpec sig_sel, sig_data;
+        for (nnode_t *mux : bank) {
+            sig_sel.append(selector);
+            sig_data.append(net_bit(module, mux->input_pins[num_selectors + j]->net));
+        }
+
+        Yosys::RTLIL::SigSpec sig_term = (num_selectors == 1) ? sig_y : Yosys::RTLIL::SigSpec(module->addWire(NEW_ID, width));
+        module->addAnd(NEW_ID, sig_sel, sig_data, sig_term);
+
+        if (j == 0) {
+            sig_sum = sig_term;
+        } else {
+            Yosys::RTLIL::SigSpec sig_next = (j == num_selectors - 1) ? sig_y : Yosys::RTLIL::SigSpec(module->addWire(NEW_ID, width));
+            module->addOr(NEW_ID, sig_sum, sig_term, sig_next);
+            sig_sum = sig_next;
+        }
+    }
+
+    stats.mux_banks++;
+    stats.banked_muxes += width;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: mux_to_lut)
+ * 	Emits a mux narrow enough for the LUTs of the architecture as a single $lut, wider ones
+ * 	are left to define_MUX_function_yosys
+ *-------------------------------------------------------------------------------------------*/
+static void mux_to_lut(Yosys::Module *module, nnode_t *node, Yosys::hashlib::pool<nnode_t *> &grouped, group_stats_t &stats)
+{
+    int num_selectors = node->input_port_sizes[0];
+    int lut_width = node->num_input_pins;
+
+    if (physical_lut_size < 1 || lut_width > physical_lut_size)
+        return;
+
+    /* the selectors are the low bits of the LUT address, the data the high bits */
+    std::vector<Yosys::RTLIL::State> table(1 << lut_width);
+    for (int address = 0; address < (1 << lut_width); address++) {
+        int selected = address & (address >> num_selectors) & ((1 << num_selectors) - 1);
+        table[address] = (selected) ? Yosys::RTLIL::State::S1 : Yosys::RTLIL::State::S0;
+    }
+
+    module->addLut(NEW_ID, input_port_sig(module, node, 0, lut_width), claim_output_sig(module, {node->output_pins[0]->net}), table);
+
+    grouped.insert(node);
+    stats.mux_luts++;
+}
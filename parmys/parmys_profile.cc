@@ -0,0 +1,172 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "kernel/yosys.h"
+
+#include "ObjectPool.hpp"
+#include "odin_util.h"
+#include "parmys_profile.hpp"
+
+/* one measured phase, nested phases record their parent's depth + 1 */
+struct profile_record_t {
+    std::string phase;
+    int depth;
+    double wall_start;
+    double cpu_start;
+    long peak_rss_start;
+
+    double wall_time;
+    double cpu_time;
+    long peak_rss_delta;
+    long num_nodes;
+    long num_pins;
+    long num_nets;
+};
+
+static bool profiling = false;
+static std::vector<profile_record_t> records;
+static std::vector<size_t> open_records;
+
+/*---------------------------------------------------------------------------------------------
+ * (function: cpu_time)
+ * 	user + system time of the process in seconds
+ *-------------------------------------------------------------------------------------------*/
+static double cpu_time() { return (double)clock() / CLOCKS_PER_SEC; }
+
+/*---------------------------------------------------------------------------------------------
+ * (function: peak_rss)
+ * 	peak resident set size of the process in KB, 0 where it is not available
+ *-------------------------------------------------------------------------------------------*/
+static long peak_rss()
+{
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+void profile_enable(bool enable)
+{
+    profiling = enable;
+    records.clear();
+    open_records.clear();
+}
+
+bool profile_enabled() { return profiling; }
+
+/*---------------------------------------------------------------------------------------------
+ * (function: profile_begin)
+ * 	starts measuring a phase, every call is closed by profile_end
+ *-------------------------------------------------------------------------------------------*/
+void profile_begin(const char *phase)
+{
+    if (!profiling)
+        return;
+
+    profile_record_t record = {};
+    record.phase = phase;
+    record.depth = (int)open_records.size();
+    record.wall_start = wall_time();
+    record.cpu_start = cpu_time();
+    record.peak_rss_start = peak_rss();
+
+    open_records.push_back(records.size());
+    records.push_back(record);
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: profile_end)
+ * 	closes the innermost open phase and samples the netlist size (if any) after it
+ *-------------------------------------------------------------------------------------------*/
+void profile_end(netlist_t *netlist)
+{
+    if (!profiling)
+        return;
+
+    oassert(!open_records.empty());
+    profile_record_t &record = records[open_records.back()];
+    open_records.pop_back();
+
+    record.wall_time = wall_time() - record.wall_start;
+    record.cpu_time = cpu_time() - record.cpu_start;
+    record.peak_rss_delta = peak_rss() - record.peak_rss_start;
+
+    if (netlist && netlist->arena) {
+        record.num_nodes = netlist->arena->nodes.size();
+        record.num_pins = netlist->arena->pins.size();
+        record.num_nets = netlist->arena->nets.size();
+    } else {
+        record.num_nodes = record.num_pins = record.num_nets = -1;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: profile_report)
+ * 	logs the recorded phases as a table followed by the same data as JSON,
+ * 	the JSON is also written to json_file unless it is empty
+ *-------------------------------------------------------------------------------------------*/
+void profile_report(const std::string &json_file)
+{
+    if (!profiling || records.empty())
+        return;
+
+    Yosys::log("\nparmys profile\n");
+    Yosys::log("%-32s %12s %12s %14s %10s %10s %10s\n", "phase", "wall (ms)", "cpu (ms)", "peak rss (KB)", "nodes", "pins", "nets");
+    for (const profile_record_t &record : records) {
+        std::string phase = std::string(2 * record.depth, ' ') + record.phase;
+        Yosys::log("%-32s %12.1f %12.1f %+14ld %10ld %10ld %10ld\n", phase.c_str(), record.wall_time * 1000, record.cpu_time * 1000,
+                   record.peak_rss_delta, record.num_nodes, record.num_pins, record.num_nets);
+    }
+
+    std::string json = "{\"phases\": [";
+    for (size_t i = 0; i < records.size(); i++) {
+        const profile_record_t &record = records[i];
+        json += Yosys::stringf("%s\n  {\"phase\": \"%s\", \"depth\": %d, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_delta_kb\": %ld, "
+                               "\"nodes\": %ld, \"pins\": %ld, \"nets\": %ld}",
+                               (i) ? "," : "", record.phase.c_str(), record.depth, record.wall_time * 1000, record.cpu_time * 1000,
+                               record.peak_rss_delta, record.num_nodes, record.num_pins, record.num_nets);
+    }
+    json += "\n]}\n";
+
+    Yosys::log("\n%s", json.c_str());
+
+    if (!json_file.empty()) {
+        FILE *out = fopen(json_file.c_str(), "w");
+        if (out == NULL) {
+            Yosys::log_warning("Could not open %s to write the profile\n", json_file.c_str());
+        } else {
+            fputs(json.c_str(), out);
+            fclose(out);
+        }
+    }
+}
@@ -26,6 +26,7 @@
 
 #include <string.h>
 
+#include "netlist_traversal.h"
 #include "netlist_utils.h"
 
 #include "BlockMemories.hpp"
@@ -63,6 +64,8 @@ void resolve_top(netlist_t *netlist)
         dfs_resolve(netlist->vcc_node, RESOLVE_DFS_VALUE, netlist);
         dfs_resolve(netlist->pad_node, RESOLVE_DFS_VALUE, netlist);
 
+        implement_constant_multipliers(netlist);
+
         look_for_clocks(netlist);
 
         configuration.coarsen = false;
@@ -71,29 +74,7 @@ void resolve_top(netlist_t *netlist)
 
 void dfs_resolve(nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist)
 {
-    int i, j;
-
-    if (node->traverse_visited != traverse_mark_number) {
-
-        node->traverse_visited = traverse_mark_number;
-
-        for (i = 0; i < node->num_output_pins; i++) {
-            if (node->output_pins[i]->net) {
-                nnet_t *next_net = node->output_pins[i]->net;
-                if (next_net->fanout_pins) {
-                    for (j = 0; j < next_net->num_fanout_pins; j++) {
-                        if (next_net->fanout_pins[j]) {
-                            if (next_net->fanout_pins[j]->node) {
-                                dfs_resolve(next_net->fanout_pins[j]->node, traverse_mark_number, netlist);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        resolve_node(node, traverse_mark_number, netlist);
-    }
+    walk_fanout_post_order(node, traverse_mark_number, [&](nnode_t *visited) { resolve_node(visited, traverse_mark_number, netlist); });
 }
 
 void resolve_node(nnode_t *node, short traverse_number, netlist_t *netlist)
@@ -164,9 +145,11 @@ static void resolve_arithmetic_nodes(nnode_t *node, uintptr_t traverse_mark_numb
         break;
     }
     case MULTIPLY: {
-        if (!hard_multipliers)
-            check_constant_multipication(node, traverse_mark_number, netlist);
-        else
+        /* constant multiplications are rewritten once the traversal is done */
+        if (check_constant_multipication(node, traverse_mark_number, netlist))
+            break;
+
+        if (hard_multipliers)
             check_multiplier_port_size(node);
 
         mult_list = insert_in_vptr_list(mult_list, node);
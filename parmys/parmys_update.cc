@@ -25,6 +25,7 @@
 #include "vtr_memory.h"
 #include "vtr_util.h"
 
+#include "netlist_traversal.h"
 #include "node_creation_library.h"
 
 #include "adders.h"
@@ -32,177 +33,73 @@
 #include "multipliers.h"
 
 #include "kernel/rtlil.h"
+#include "parmys_group.hpp"
 #include "parmys_update.hpp"
 #include "parmys_utils.hpp"
 
-static void depth_first_traversal_to_design(short marker_value, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design);
+static void depth_first_traversal_to_design(short marker_value, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design,
+                                            const Yosys::hashlib::pool<nnode_t *> &grouped);
 static void depth_traverse_update_design(nnode_t *node, uintptr_t traverse_mark_number, Yosys::Module *module, netlist_t *netlist,
-                                         Yosys::Design *design);
+                                         Yosys::Design *design, const Yosys::hashlib::pool<nnode_t *> &grouped);
 static void cell_node(nnode_t *node, short /*traverse_number*/, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design);
 
-Yosys::Wire *wire_net_driver(Yosys::Module *module, nnode_t *node, nnet_t *net, long driver_idx)
+/*---------------------------------------------------------------------------------------------
+ * (function: update_design)
+ * 	Puts the mapped netlist in place of the cells to_netlist extracted from the top module.
+ * 	Nets are resolved to bits of the module (see net_bit): the boundary inputs read the bits
+ * 	they stand for, every other net gets a bit of a fresh wire. Unless disabled, adder chains
+ * 	and mux banks are emitted as wide cells first (see group_soft_logic), the other nodes get
+ * 	one cell each. Only the extracted cells are removed, every other cell, wire and module
+ * 	(black boxes included) is left as it is.
+ *-------------------------------------------------------------------------------------------*/
+void update_design(Yosys::Design *design, netlist_t *netlist, const extraction_t &extraction)
 {
-    oassert(driver_idx < net->num_driver_pins);
-    npin_t *driver = net->driver_pins[driver_idx];
-    std::string wire_name;
-    if (!driver->node) {
-        // Add a warning for an undriven net.
-        warning_message(NETLIST, node->loc, "Net %s driving node %s is itself undriven.", net->name, node->name);
-
-        wire_name = "$undef";
-    } else {
-        if (driver->name != NULL && ((driver->node->type == MULTIPLY) || (driver->node->type == HARD_IP) || (driver->node->type == MEMORY) ||
-                                     (driver->node->type == ADD) || (driver->node->type == MINUS) || (driver->node->type == SKIP))) {
-            wire_name = driver->name;
-        } else {
-            wire_name = driver->node->name;
-        }
-    }
-
-    return to_wire(wire_name, module);
-}
-
-Yosys::Wire *wire_input_single_driver(Yosys::Module *module, nnode_t *node, long pin_idx)
-{
-    oassert(pin_idx < node->num_input_pins);
-    nnet_t *net = node->input_pins[pin_idx]->net;
-    if (!net->num_driver_pins) {
-        return to_wire("$undef", module);
-    } else {
-        oassert(net->num_driver_pins == 1);
-        return wire_net_driver(module, node, net, 0);
-    }
-}
-
-Yosys::Wire *wire_output_pin(Yosys::Module *module, nnode_t *node)
-{
-    Yosys::RTLIL::IdString wire_name(Yosys::stringf("\\%s", node->name));
-    Yosys::RTLIL::Wire *wire = module->wire(wire_name);
-    if (wire == nullptr)
-        wire = module->addWire(wire_name);
+    Yosys::RTLIL::Module *module = extraction.module;
 
-    return wire;
-}
+    for (auto cell : extraction.cells)
+        module->remove(cell);
 
-void update_design(Yosys::Design *design, netlist_t *netlist)
-{
-    Yosys::RTLIL::Module *module = nullptr;
-    std::string err_reason;
-    int blif_maxnum = 0;
-
-    Yosys::hashlib::dict<Yosys::RTLIL::IdString, std::pair<int, bool>> wideports_cache;
-
-    module = new Yosys::RTLIL::Module;
-    module->name = Yosys::RTLIL::escape_id(strtok(netlist->identifier, " \t\r\n"));
-
-    if (design->module(module->name))
-        Yosys::log_error("Duplicate definition of module %s\n", Yosys::log_id(module->name));
-    design->add(module);
-
-    Yosys::RTLIL::SigSpec undef;
-    undef.append(to_wire("$undef", module));
-    module->connect(Yosys::RTLIL::SigSig(undef, Yosys::RTLIL::State::Sx));
-    Yosys::RTLIL::SigSpec vcc;
-    vcc.append(to_wire("$true", module));
-    // vcc.append(module->wire(ID($true)));
-    module->connect(Yosys::RTLIL::SigSig(vcc, Yosys::RTLIL::State::S1));
-    Yosys::RTLIL::SigSpec gnd;
-    gnd.append(to_wire("$false", module));
-    module->connect(Yosys::RTLIL::SigSig(gnd, Yosys::RTLIL::State::S0));
+    Yosys::hashlib::dict<nnode_t *, Yosys::RTLIL::SigBit> boundary_inputs;
+    for (auto &in : extraction.inputs)
+        boundary_inputs[in.first] = in.second;
 
     for (long i = 0; i < netlist->num_top_input_nodes; i++) {
         nnode_t *top_input_node = netlist->top_input_nodes[i];
-        Yosys::RTLIL::Wire *wire = to_wire(top_input_node->name, module);
-        wire->port_input = true;
-
-        std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(top_input_node->name);
-        if (!wp.first.empty() && wp.second >= 0) {
-            wideports_cache[wp.first].first = std::max(wideports_cache[wp.first].first, wp.second + 1);
-            wideports_cache[wp.first].second = true;
-        }
-    }
-
-    for (long i = 0; i < netlist->num_top_output_nodes; i++) {
-        nnode_t *top_output_node = netlist->top_output_nodes[i];
-        if (!top_output_node->input_pins[0]->net->num_driver_pins) {
-            Yosys::log_warning("This output is undriven (%s) and will be removed\n", top_output_node->name);
-        } else {
-            Yosys::RTLIL::Wire *wire = to_wire(top_output_node->name, module);
-            wire->port_output = true;
-
-            std::pair<Yosys::RTLIL::IdString, int> wp = wideports_split(top_output_node->name);
-            if (!wp.first.empty() && wp.second >= 0) {
-                wideports_cache[wp.first].first = std::max(wideports_cache[wp.first].first, wp.second + 1);
-                wideports_cache[wp.first].second = false;
+        if (top_input_node == NULL || !boundary_inputs.count(top_input_node))
+            continue;
+
+        for (long j = 0; j < top_input_node->num_output_pins; j++) {
+            nnet_t *net = top_input_node->output_pins[j]->net;
+            if (net) {
+                net->yosys_bit = boundary_inputs.at(top_input_node);
+                net->has_yosys_bit = true;
             }
         }
     }
 
-    depth_first_traversal_to_design(100, module, netlist, design);
-
-    /* connect all the outputs up to the last gate */
-    for (long i = 0; i < netlist->num_top_output_nodes; i++) {
-        nnode_t *node = netlist->top_output_nodes[i];
-
-        if (node->input_pins[0]->net->num_fanout_pins > 0) {
-            nnet_t *net = node->input_pins[0]->net;
-            for (int j = 0; j < net->num_driver_pins; j++) {
-                Yosys::Wire *driver_wire = wire_net_driver(module, node, net, j);
-                Yosys::Wire *out_wire = to_wire(node->name, module);
-
-                Yosys::RTLIL::SigSpec input_sig, output_sig;
-                input_sig.append(driver_wire);
-                output_sig.append(out_wire);
-
-                module->connect(output_sig, input_sig);
-            }
-        }
-    }
-
-    handle_wideports_cache(&wideports_cache, module);
-
-    module->fixup_ports();
-    wideports_cache.clear();
-
-    bool run_clean = true;
-    if (run_clean) {
-        Yosys::Const buffer_lut(std::vector<Yosys::RTLIL::State>({Yosys::State::S0, Yosys::State::S1}));
-        std::vector<Yosys::Cell *> remove_cells;
-
-        for (auto cell : module->cells())
-            if (cell->type == ID($lut) && cell->getParam(Yosys::ID::LUT) == buffer_lut) {
-                module->connect(cell->getPort(Yosys::ID::Y), cell->getPort(Yosys::ID::A));
-                remove_cells.push_back(cell);
-            }
-
-        for (auto cell : remove_cells)
-            module->remove(cell);
-
-        Yosys::Wire *true_wire = module->wire(ID($true));
-        Yosys::Wire *false_wire = module->wire(ID($false));
-        Yosys::Wire *undef_wire = module->wire(ID($undef));
-
-        if (true_wire != nullptr)
-            module->rename(true_wire, Yosys::stringf("$true$%d", ++blif_maxnum));
-
-        if (false_wire != nullptr)
-            module->rename(false_wire, Yosys::stringf("$false$%d", ++blif_maxnum));
+    Yosys::hashlib::pool<nnode_t *> grouped;
+    if (global_args.group_soft_logic)
+        group_soft_logic(module, netlist, grouped);
 
-        if (undef_wire != nullptr)
-            module->rename(undef_wire, Yosys::stringf("$undef$%d", ++blif_maxnum));
+    depth_first_traversal_to_design(100, module, netlist, design, grouped);
 
-        blif_maxnum = 0;
+    /* connect all the outputs up to the last gate */
+    for (auto &out : extraction.outputs) {
+        nnet_t *net = out.first->input_pins[0]->net;
+        if (!net->num_driver_pins)
+            Yosys::log_warning("This output is undriven (%s) and will be removed\n", out.first->name);
+        else
+            module->connect(out.second, net_bit(module, net));
     }
 
     add_the_blackbox_for_mults_yosys(design);
     add_the_blackbox_for_adds_yosys(design);
 
     output_hard_blocks_yosys(design);
-
-    module = nullptr;
 }
 
-void depth_first_traversal_to_design(short marker_value, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design)
+void depth_first_traversal_to_design(short marker_value, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design,
+                                     const Yosys::hashlib::pool<nnode_t *> &grouped)
 {
     int i;
 
@@ -212,47 +109,33 @@ void depth_first_traversal_to_design(short marker_value, Yosys::Module *module,
         netlist->pad_node->name = vtr::strdup("$undef");
     }
 
-    depth_traverse_update_design(netlist->gnd_node, marker_value, module, netlist, design);
-    depth_traverse_update_design(netlist->vcc_node, marker_value, module, netlist, design);
-    depth_traverse_update_design(netlist->pad_node, marker_value, module, netlist, design);
+    depth_traverse_update_design(netlist->gnd_node, marker_value, module, netlist, design, grouped);
+    depth_traverse_update_design(netlist->vcc_node, marker_value, module, netlist, design, grouped);
+    depth_traverse_update_design(netlist->pad_node, marker_value, module, netlist, design, grouped);
 
     for (i = 0; i < netlist->num_top_input_nodes; i++) {
         if (netlist->top_input_nodes[i] != NULL) {
-            depth_traverse_update_design(netlist->top_input_nodes[i], marker_value, module, netlist, design);
+            depth_traverse_update_design(netlist->top_input_nodes[i], marker_value, module, netlist, design, grouped);
         }
     }
 }
 
-void depth_traverse_update_design(nnode_t *node, uintptr_t traverse_mark_number, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design)
+void depth_traverse_update_design(nnode_t *node, uintptr_t traverse_mark_number, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design,
+                                  const Yosys::hashlib::pool<nnode_t *> &grouped)
 {
-    int i, j;
-    nnode_t *next_node;
-    nnet_t *next_net;
-
-    if (node->traverse_visited == traverse_mark_number) {
-        return;
-    } else {
-        cell_node(node, traverse_mark_number, module, netlist, design);
-
-        node->traverse_visited = traverse_mark_number;
-
-        for (i = 0; i < node->num_output_pins; i++) {
-            if (node->output_pins[i]->net == NULL)
-                continue;
-
-            next_net = node->output_pins[i]->net;
-            for (j = 0; j < next_net->num_fanout_pins; j++) {
-                if (next_net->fanout_pins[j] == NULL)
-                    continue;
-
-                next_node = next_net->fanout_pins[j]->node;
-                if (next_node == NULL)
-                    continue;
-
-                depth_traverse_update_design(next_node, traverse_mark_number, module, netlist, design);
-            }
-        }
-    }
+    /* cells are emitted in pre-order, before the node is marked, grouped nodes were emitted already */
+    walk_fanout(
+      node, 0,
+      [&](nnode_t *visited, nnode_t *, int &) {
+          if (visited->traverse_visited == traverse_mark_number)
+              return false;
+
+          if (!grouped.count(visited))
+              cell_node(visited, traverse_mark_number, module, netlist, design);
+          visited->traverse_visited = traverse_mark_number;
+          return true;
+      },
+      [](nnode_t *, int) {});
 }
 
 void cell_node(nnode_t *node, short /*traverse_number*/, Yosys::Module *module, netlist_t *netlist, Yosys::Design *design)
@@ -353,20 +236,24 @@ void cell_node(nnode_t *node, short /*traverse_number*/, Yosys::Module *module,
 
 void define_FF_yosys(nnode_t *node, Yosys::Module *module)
 {
-    Yosys::Wire *d = wire_input_single_driver(module, node, 0);
-    Yosys::Wire *q = wire_output_pin(module, node);
+    oassert(node->num_input_pins >= 2);
+    oassert(node->input_pins[0]->net->num_driver_pins <= 1);
+    oassert(node->input_pins[1]->net->num_driver_pins <= 1);
+
+    Yosys::SigBit d = net_bit(module, node->input_pins[0]->net);
+    Yosys::SigBit q = output_port_sig(module, node, 0, 1).as_bit();
     const char *clk_edge_type_str = edge_type_blif_str(node->attributes->clk_edge_type, node->loc);
     char *edge = vtr::strdup(clk_edge_type_str);
-    Yosys::Wire *clock = wire_input_single_driver(module, node, 1);
+    Yosys::SigBit clock = net_bit(module, node->input_pins[1]->net);
 
-    if (clock == nullptr && edge != nullptr) {
-        edge = nullptr;
+    if ((node->initial_value == init_value_e::_0 || node->initial_value == init_value_e::_1) && q.wire != nullptr) {
+        Yosys::Const init = (q.wire->attributes.count(Yosys::ID::init)) ? q.wire->attributes.at(Yosys::ID::init)
+                                                                        : Yosys::Const(Yosys::RTLIL::State::Sx, q.wire->width);
+        init.bits[q.offset] = (node->initial_value == init_value_e::_1) ? Yosys::RTLIL::State::S1 : Yosys::RTLIL::State::S0;
+        q.wire->attributes[Yosys::ID::init] = init;
     }
 
-    if (node->initial_value == init_value_e::_0 || node->initial_value == init_value_e::_1)
-        q->attributes[Yosys::ID::init] = Yosys::Const(node->initial_value, 1);
-
-    if (clock == nullptr)
+    if (edge == nullptr)
         goto no_latch_clock;
 
     if (!strcmp(edge, "re"))
@@ -389,30 +276,10 @@ void define_MUX_function_yosys(nnode_t *node, Yosys::Module *module)
     oassert(node->num_input_port_sizes == 2);
     oassert(node->input_port_sizes[0] == node->input_port_sizes[1]);
 
-    Yosys::RTLIL::SigSpec input_sig_A, input_sig_B, buf_sig_M, output_sig;
-
-    for (int i = 0; i < node->input_port_sizes[0]; i++) {
-        nnet_t *input_net = node->input_pins[i]->net;
-        Yosys::Wire *driver_wire = wire_net_driver(module, node, input_net, 0);
-
-        input_sig_A.append(driver_wire);
-    }
-
-    for (int i = node->input_port_sizes[0]; i < node->num_input_pins; i++) {
-        nnet_t *input_net = node->input_pins[i]->net;
-        Yosys::Wire *driver_wire = wire_net_driver(module, node, input_net, 0);
-
-        input_sig_B.append(driver_wire);
-    }
-
-    for (int i = 0; i < node->input_port_sizes[0]; i++) {
-        std::string mid_buf_name = op_node_name(BUF_NODE, node->name);
-        Yosys::RTLIL::Wire *buf_wire = to_wire(mid_buf_name, module);
-        buf_sig_M.append(buf_wire);
-    }
-
-    Yosys::RTLIL::Wire *out_wire = to_wire(node->name, module);
-    output_sig.append(out_wire);
+    Yosys::RTLIL::SigSpec input_sig_A = input_port_sig(module, node, 0, node->input_port_sizes[0]);
+    Yosys::RTLIL::SigSpec input_sig_B = input_port_sig(module, node, node->input_port_sizes[0], node->num_input_pins - node->input_port_sizes[0]);
+    Yosys::RTLIL::SigSpec buf_sig_M = module->addWire(NEW_ID, node->input_port_sizes[0]);
+    Yosys::RTLIL::SigSpec output_sig = output_port_sig(module, node, 0, node->num_output_pins);
 
     Yosys::IdString celltype_1 = ID($and);
     Yosys::RTLIL::Cell *cell_1 = module->addCell(NEW_ID, celltype_1);
@@ -436,17 +303,8 @@ void define_MUX_function_yosys(nnode_t *node, Yosys::Module *module)
 
 void define_logical_function_yosys(nnode_t *node, Yosys::Module *module)
 {
-    Yosys::RTLIL::SigSpec input_sig, output_sig;
-
-    for (int i = 0; i < node->num_input_pins; i++) {
-        nnet_t *input_net = node->input_pins[i]->net;
-        Yosys::Wire *driver_wire = wire_net_driver(module, node, input_net, 0); // 0 TODO?
-
-        input_sig.append(driver_wire);
-    }
-
-    Yosys::RTLIL::Wire *out_wire = to_wire(node->name, module);
-    output_sig.append(out_wire);
+    Yosys::RTLIL::SigSpec input_sig = input_port_sig(module, node, 0, node->num_input_pins);
+    Yosys::RTLIL::SigSpec output_sig = output_port_sig(module, node, 0, node->num_output_pins);
 
     oassert(node->num_output_pins == 1);
 
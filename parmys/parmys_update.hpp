@@ -1,12 +1,23 @@
 #ifndef __DESIGN_UPDATE_H__
 #define __DESIGN_UPDATE_H__
 
+#include <utility>
+#include <vector>
+
 #include "odin_types.h"
 
 #define DEFAULT_CLOCK_NAME "GLOBAL_SIM_BASE_CLK"
 
+/* the part of the top module handed to odin */
+struct extraction_t {
+    Yosys::RTLIL::Module *module;
+    std::vector<Yosys::RTLIL::Cell *> cells;                            // cells replaced by the mapped netlist
+    std::vector<std::pair<nnode_t *, Yosys::RTLIL::SigBit>> inputs;  // top input node, the bit it reads
+    std::vector<std::pair<nnode_t *, Yosys::RTLIL::SigBit>> outputs; // top output node, the bit it drives
+};
+
 void define_logical_function_yosys(nnode_t *node, Yosys::Module *module);
-void update_design(Yosys::Design *design, netlist_t *netlist);
+void update_design(Yosys::Design *design, netlist_t *netlist, const extraction_t &extraction);
 void define_MUX_function_yosys(nnode_t *node, Yosys::Module *module);
 void define_FF_yosys(nnode_t *node, Yosys::Module *module);
 
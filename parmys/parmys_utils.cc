@@ -21,6 +21,8 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
 #include "parmys_utils.hpp"
 
 Yosys::Wire *to_wire(std::string wire_name, Yosys::Module *module)
@@ -34,6 +36,26 @@ Yosys::Wire *to_wire(std::string wire_name, Yosys::Module *module)
     return wire;
 }
 
+/*---------------------------------------------------------------------------------------------
+ * (function: blackbox_defined)
+ * 	Returns true if the design already has a black box named name. A module of that name that
+ * 	is not a black box (e.g. the body of a vtr primitive, kept by -partial) is removed, so the
+ * 	caller can define the black box in its place.
+ *-------------------------------------------------------------------------------------------*/
+bool blackbox_defined(Yosys::Design *design, Yosys::RTLIL::IdString name)
+{
+    Yosys::Module *module = design->module(name);
+
+    if (module == nullptr)
+        return false;
+
+    if (module->get_blackbox_attribute())
+        return true;
+
+    design->remove(module);
+    return false;
+}
+
 std::pair<Yosys::RTLIL::IdString, int> wideports_split(std::string name)
 {
     int pos = -1;
@@ -94,38 +116,138 @@ const std::string str(Yosys::RTLIL::IdString id)
     return str;
 }
 
-void handle_cell_wideports_cache(Yosys::hashlib::dict<Yosys::RTLIL::IdString, Yosys::hashlib::dict<int, Yosys::SigBit>> *cell_wideports_cache,
-                                 Yosys::Design *design, Yosys::Module *module, Yosys::Cell *cell)
+/*---------------------------------------------------------------------------------------------
+ * (function: set_cell_port)
+ * 	Connects sig to port of cell, sig[i] going to port[i] as the module of the cell declares
+ * 	the port (offset, direction). Bits of the port sig does not cover get a fresh wire.
+ *-------------------------------------------------------------------------------------------*/
+void set_cell_port(Yosys::Design *design, Yosys::Cell *cell, Yosys::RTLIL::IdString port, const Yosys::SigSpec &sig)
 {
     Yosys::RTLIL::Module *cell_mod = design->module(cell->type);
-    for (auto &it : *cell_wideports_cache) {
-        int width = 0;
-        int offset = 0;
-        bool upto = false;
-        for (auto &b : it.second)
-            width = std::max(width, b.first + 1);
-
-        if (cell_mod) {
-            Yosys::Wire *cell_port = cell_mod->wire(it.first);
-            if (cell_port && (cell_port->port_input || cell_port->port_output)) {
-                offset = cell_port->start_offset;
-                upto = cell_port->upto;
-                width = cell_port->width;
-            }
+    Yosys::Wire *cell_port = (cell_mod) ? cell_mod->wire(port) : nullptr;
+
+    if (cell_port == nullptr || !(cell_port->port_input || cell_port->port_output) ||
+        (cell_port->width == sig.size() && cell_port->start_offset == 0 && !cell_port->upto)) {
+        cell->setPort(port, sig);
+        return;
+    }
+
+    Yosys::SigSpec port_sig;
+    for (int i = 0; i < cell_port->width; i++) {
+        int idx = cell_port->start_offset + (cell_port->upto ? cell_port->width - 1 - i : i);
+        if (idx >= 0 && idx < sig.size())
+            port_sig.append(sig[idx]);
+        else
+            port_sig.append(cell->module->addWire(NEW_ID));
+    }
+
+    cell->setPort(port, port_sig);
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: resolve_output_port)
+ * 	Creates one wire for the output port of node holding pin_idx and hands its bits to the
+ * 	nets of the port that are not resolved yet
+ *-------------------------------------------------------------------------------------------*/
+static void resolve_output_port(Yosys::Module *module, nnode_t *node, long pin_idx)
+{
+    long start = 0;
+    long width = node->num_output_pins;
+    for (int port = 0; port < node->num_output_port_sizes; port++) {
+        if (pin_idx < start + node->output_port_sizes[port]) {
+            width = node->output_port_sizes[port];
+            break;
         }
+        start += node->output_port_sizes[port];
+    }
+    width = std::min(width, node->num_output_pins - start);
 
-        Yosys::SigSpec sig;
+    int num_bits = 0;
+    for (long i = start; i < start + width; i++) {
+        nnet_t *net = node->output_pins[i]->net;
+        if (net && !net->has_yosys_bit)
+            num_bits++;
+    }
 
-        for (int i = 0; i < width; i++) {
-            int idx = offset + (upto ? width - 1 - i : i);
-            if (it.second.count(idx))
-                sig.append(it.second.at(idx));
-            else
-                sig.append(module->addWire(NEW_ID));
+    Yosys::Wire *wire = module->addWire(NEW_ID, num_bits);
+
+    int offset = 0;
+    for (long i = start; i < start + width; i++) {
+        nnet_t *net = node->output_pins[i]->net;
+        if (net && !net->has_yosys_bit) {
+            net->yosys_bit = Yosys::SigBit(wire, offset++);
+            net->has_yosys_bit = true;
         }
+    }
+}
 
-        cell->setPort(it.first, sig);
+/*---------------------------------------------------------------------------------------------
+ * (function: net_bit)
+ * 	Returns the bit of module carrying net. It is resolved through the first driver of the
+ * 	net and cached in it: a constant for the gnd/vcc/pad nets and undriven nets, a bit of the
+ * 	output port wire of the driver otherwise. Nets of boundary inputs are set up front.
+ *-------------------------------------------------------------------------------------------*/
+Yosys::SigBit net_bit(Yosys::Module *module, nnet_t *net)
+{
+    if (!net->has_yosys_bit) {
+        npin_t *driver = (net->num_driver_pins) ? net->driver_pins[0] : NULL;
+
+        if (driver == NULL || driver->node == NULL) {
+            net->yosys_bit = Yosys::RTLIL::State::Sx;
+            net->has_yosys_bit = true;
+        } else if (driver->node->type == GND_NODE) {
+            net->yosys_bit = Yosys::RTLIL::State::S0;
+            net->has_yosys_bit = true;
+        } else if (driver->node->type == VCC_NODE) {
+            net->yosys_bit = Yosys::RTLIL::State::S1;
+            net->has_yosys_bit = true;
+        } else if (driver->node->type == PAD_NODE) {
+            net->yosys_bit = Yosys::RTLIL::State::Sx;
+            net->has_yosys_bit = true;
+        } else {
+            resolve_output_port(module, driver->node, driver->pin_node_idx);
+        }
     }
+
+    return net->yosys_bit;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: input_port_sig)
+ * 	Returns the bits read by the input pins [start, start + width) of node
+ *-------------------------------------------------------------------------------------------*/
+Yosys::SigSpec input_port_sig(Yosys::Module *module, nnode_t *node, long start, long width)
+{
+    Yosys::SigSpec sig;
+
+    for (long i = start; i < start + width; i++) {
+        nnet_t *net = node->input_pins[i]->net;
+        if (net->num_driver_pins && net->driver_pins[0]->node == NULL)
+            warning_message(NETLIST, node->loc, "Net %s driving node %s is itself undriven.", net->name, node->name);
+
+        sig.append(net_bit(module, net));
+    }
+
+    return sig;
+}
+
+/*---------------------------------------------------------------------------------------------
+ * (function: output_port_sig)
+ * 	Returns the bits driven by the output pins [start, start + width) of node
+ *-------------------------------------------------------------------------------------------*/
+Yosys::SigSpec output_port_sig(Yosys::Module *module, nnode_t *node, long start, long width)
+{
+    Yosys::SigSpec sig;
+
+    for (long i = start; i < start + width; i++) {
+        nnet_t *net = node->output_pins[i]->net;
+        if (net)
+            sig.append(net_bit(module, net));
+        else
+            sig.append(module->addWire(NEW_ID));
+    }
+
+    return sig;
 }
 
 void handle_wideports_cache(Yosys::hashlib::dict<Yosys::RTLIL::IdString, std::pair<int, bool>> *wideports_cache, Yosys::Module *module)
@@ -27,11 +27,14 @@
 #include "odin_types.h"
 
 Yosys::Wire *to_wire(std::string wire_name, Yosys::Module *module);
+bool blackbox_defined(Yosys::Design *design, Yosys::RTLIL::IdString name);
 std::pair<Yosys::RTLIL::IdString, int> wideports_split(std::string name);
 const std::string str(Yosys::RTLIL::SigBit sig);
 const std::string str(Yosys::RTLIL::IdString id);
-void handle_cell_wideports_cache(Yosys::hashlib::dict<Yosys::RTLIL::IdString, Yosys::hashlib::dict<int, Yosys::SigBit>> *cell_wideports_cache,
-                                 Yosys::Design *design, Yosys::Module *module, Yosys::Cell *cell);
+void set_cell_port(Yosys::Design *design, Yosys::Cell *cell, Yosys::RTLIL::IdString port, const Yosys::SigSpec &sig);
+Yosys::SigBit net_bit(Yosys::Module *module, nnet_t *net);
+Yosys::SigSpec input_port_sig(Yosys::Module *module, nnode_t *node, long start, long width);
+Yosys::SigSpec output_port_sig(Yosys::Module *module, nnode_t *node, long start, long width);
 void handle_wideports_cache(Yosys::hashlib::dict<Yosys::RTLIL::IdString, std::pair<int, bool>> *wideports_cache, Yosys::Module *module);
 
 #endif //__YOSYS_UTILS_H__
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "netlist_traversal.h"
 #include "netlist_utils.h"
 #include "node_creation_library.h"
 #include "odin_util.h"
@@ -74,6 +75,12 @@ void partial_map_top(netlist_t *netlist) { depth_first_traversal_to_partial_map(
 
 /*---------------------------------------------------------------------------------------------
  * (function: depth_first_traversal_to_parital_map()
+ * 	maps the nodes one at a time in a post order walk from the top inputs. The walk is kept
+ * 	sequential: every instantiate_* routine adds and removes fanout pins on nets shared with
+ * 	the neighbouring nodes and draws the nodes, pins and nets it creates from the global
+ * 	next_unique_id counter and the active netlist arena, and multipliers are noted on the
+ * 	global mixer, so no two nodes can be mapped at the same time without per-thread copies
+ * 	of all of these.
  *-------------------------------------------------------------------------------------------*/
 void depth_first_traversal_to_partial_map(short marker_value, netlist_t *netlist)
 {
@@ -93,29 +100,7 @@ void depth_first_traversal_to_partial_map(short marker_value, netlist_t *netlist
  *-------------------------------------------------------------------------------------------*/
 void depth_first_traverse_partial_map(nnode_t *node, uintptr_t traverse_mark_number, netlist_t *netlist)
 {
-    int i, j;
-
-    if (node->traverse_visited != traverse_mark_number) {
-
-        node->traverse_visited = traverse_mark_number;
-
-        for (i = 0; i < node->num_output_pins; i++) {
-            if (node->output_pins[i]->net) {
-                nnet_t *next_net = node->output_pins[i]->net;
-                if (next_net->fanout_pins) {
-                    for (j = 0; j < next_net->num_fanout_pins; j++) {
-                        if (next_net->fanout_pins[j]) {
-                            if (next_net->fanout_pins[j]->node) {
-                                depth_first_traverse_partial_map(next_net->fanout_pins[j]->node, traverse_mark_number, netlist);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        partial_map_node(node, traverse_mark_number, netlist);
-    }
+    walk_fanout_post_order(node, traverse_mark_number, [&](nnode_t *visited) { partial_map_node(visited, traverse_mark_number, netlist); });
 }
 
 /*----------------------------------------------------------------------
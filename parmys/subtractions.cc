@@ -221,6 +221,7 @@ void init_split_adder_for_sub(nnode_t *node, nnode_t *ptr, int a, int sizea, int
     /* Set the number of pins and re-locate previous pin entries */
     ptr->num_input_pins = current_sizea + current_sizeb + cin;
     ptr->input_pins = (npin_t **)vtr::malloc(sizeof(void *) * (current_sizea + current_sizeb + cin));
+    ptr->input_pins_capacity = ptr->num_input_pins;
     // the normal sub: if flaga or flagb = 1, the input pins should be empty.
     // the unary sub: all input pins for a should be null, input pins for b should be connected to node
     if (node->num_input_port_sizes == 1) {
@@ -303,6 +304,7 @@ void init_split_adder_for_sub(nnode_t *node, nnode_t *ptr, int a, int sizea, int
 
     ptr->num_output_pins = output;
     ptr->output_pins = (npin_t **)vtr::malloc(sizeof(void *) * output);
+    ptr->output_pins_capacity = output;
     for (i = 0; i < output; i++)
         ptr->output_pins[i] = NULL;
 
@@ -415,11 +417,11 @@ void split_adder_for_sub(nnode_t *nodeo, int a, int b, int sizea, int sizeb, int
             oassert(not_node[i]->input_pins[0]->net->num_driver_pins == 1);
             if (not_node[i]->input_pins[0]->net->driver_pins[0]->node->type == GND_NODE) {
                 connect_nodes(netlist->vcc_node, 0, node[0], (lefta + i));
-                remove_fanout_pins_from_net(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0], not_node[i]->input_pins[0]->pin_net_idx);
+                remove_fanout_pin_unordered(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0]);
                 free_nnode(not_node[i]);
             } else if (not_node[i]->input_pins[0]->net->driver_pins[0]->node->type == VCC_NODE) {
                 connect_nodes(netlist->gnd_node, 0, node[0], (lefta + i));
-                remove_fanout_pins_from_net(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0], not_node[i]->input_pins[0]->pin_net_idx);
+                remove_fanout_pin_unordered(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0]);
                 free_nnode(not_node[i]);
             } else
                 connect_nodes(not_node[i], 0, node[0], (lefta + i));
@@ -441,11 +443,11 @@ void split_adder_for_sub(nnode_t *nodeo, int a, int b, int sizea, int sizeb, int
                 oassert(not_node[i]->input_pins[0]->net->num_driver_pins == 1);
                 if (not_node[i]->input_pins[0]->net->driver_pins[0]->node->type == GND_NODE) {
                     connect_nodes(netlist->vcc_node, 0, node[0], (sizea + i + 1));
-                    remove_fanout_pins_from_net(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0], not_node[i]->input_pins[0]->pin_net_idx);
+                    remove_fanout_pin_unordered(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0]);
                     free_nnode(not_node[i]);
                 } else if (not_node[i]->input_pins[0]->net->driver_pins[0]->node->type == VCC_NODE) {
                     connect_nodes(netlist->gnd_node, 0, node[0], (sizea + i + 1));
-                    remove_fanout_pins_from_net(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0], not_node[i]->input_pins[0]->pin_net_idx);
+                    remove_fanout_pin_unordered(not_node[i]->input_pins[0]->net, not_node[i]->input_pins[0]);
                     free_nnode(not_node[i]);
                 } else
                     connect_nodes(not_node[i], 0, node[0], (sizea + i + 1));
@@ -468,13 +470,11 @@ void split_adder_for_sub(nnode_t *nodeo, int a, int b, int sizea, int sizeb, int
                     oassert(not_node[(i * sizeb + j - 1)]->input_pins[0]->net->num_driver_pins == 1);
                     if (not_node[(i * sizeb + j - 1)]->input_pins[0]->net->driver_pins[0]->node->type == GND_NODE) {
                         connect_nodes(netlist->vcc_node, 0, node[i], (lefta + j));
-                        remove_fanout_pins_from_net(not_node[(i * sizeb + j - 1)]->input_pins[0]->net, not_node[(i * sizeb + j - 1)]->input_pins[0],
-                                                    not_node[(i * sizeb + j - 1)]->input_pins[0]->pin_net_idx);
+                        remove_fanout_pin_unordered(not_node[(i * sizeb + j - 1)]->input_pins[0]->net, not_node[(i * sizeb + j - 1)]->input_pins[0]);
                         free_nnode(not_node[(i * sizeb + j - 1)]);
                     } else if (not_node[(i * sizeb + j - 1)]->input_pins[0]->net->driver_pins[0]->node->type == VCC_NODE) {
                         connect_nodes(netlist->gnd_node, 0, node[i], (lefta + j));
-                        remove_fanout_pins_from_net(not_node[(i * sizeb + j - 1)]->input_pins[0]->net, not_node[(i * sizeb + j - 1)]->input_pins[0],
-                                                    not_node[(i * sizeb + j - 1)]->input_pins[0]->pin_net_idx);
+                        remove_fanout_pin_unordered(not_node[(i * sizeb + j - 1)]->input_pins[0]->net, not_node[(i * sizeb + j - 1)]->input_pins[0]);
                         free_nnode(not_node[(i * sizeb + j - 1)]);
                     } else
                         connect_nodes(not_node[(i * sizeb + j - 1)], 0, node[i], (lefta + j));
@@ -490,13 +490,11 @@ void split_adder_for_sub(nnode_t *nodeo, int a, int b, int sizea, int sizeb, int
                     oassert(not_node[index]->input_pins[0]->net->num_driver_pins == 1);
                     if (not_node[index]->input_pins[0]->net->driver_pins[0]->node->type == GND_NODE) {
                         connect_nodes(netlist->vcc_node, 0, node[i], (sizea + j));
-                        remove_fanout_pins_from_net(not_node[index]->input_pins[0]->net, not_node[index]->input_pins[0],
-                                                    not_node[index]->input_pins[0]->pin_net_idx);
+                        remove_fanout_pin_unordered(not_node[index]->input_pins[0]->net, not_node[index]->input_pins[0]);
                         free_nnode(not_node[index]);
                     } else if (not_node[index]->input_pins[0]->net->driver_pins[0]->node->type == VCC_NODE) {
                         connect_nodes(netlist->gnd_node, 0, node[i], (sizea + j));
-                        remove_fanout_pins_from_net(not_node[index]->input_pins[0]->net, not_node[index]->input_pins[0],
-                                                    not_node[index]->input_pins[0]->pin_net_idx);
+                        remove_fanout_pin_unordered(not_node[index]->input_pins[0]->net, not_node[index]->input_pins[0]);
                         free_nnode(not_node[index]);
                     } else
                         connect_nodes(not_node[index], 0, node[i], (sizea + j));
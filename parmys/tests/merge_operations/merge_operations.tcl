@@ -0,0 +1,64 @@
+yosys -import
+
+plugin -i parmys
+
+yosys -import
+
+# Map the given top module with parmys and return the number of adder cells.
+# opt is not run, so duplicated arithmetic reaches parmys as separate cells.
+proc count_adders { top } {
+    design -reset
+
+    read_verilog -nomem2reg +/parmys/vtr_primitives.v
+
+    parmys_arch -a ../raygentop/k6_frac_N10_frac_chain_mem32K_40nm.xml
+
+    read_verilog -sv -nolatches merge_operations.v
+
+    hierarchy -check -top $top
+
+    procs
+
+    flatten
+
+    parmys -a ../raygentop/k6_frac_N10_frac_chain_mem32K_40nm.xml -nopass
+
+    set count_file [test_output_path "${top}.count"]
+    tee -q -o $count_file select -count t:adder
+    set fh [open $count_file r]
+    set text [read $fh]
+    close $fh
+
+    if {![regexp {(\d+) objects} $text -> count]} {
+        error "could not count the adders of $top"
+    }
+    return $count
+}
+
+set single_sum [count_adders single_sum]
+set single_difference [count_adders single_difference]
+set single [count_adders single_operations]
+set duplicated [count_adders duplicated_operations]
+set swapped [count_adders swapped_operations]
+set subset [count_adders subset_operations]
+
+if {$single == 0} {
+    error "single_operations was not mapped onto adders"
+}
+
+# The exact and the commutative duplicates are merged into the node they
+# duplicate: only one adder chain is left for each operation.
+if {$duplicated != $single} {
+    error "duplicated_operations has $duplicated adders, expected $single"
+}
+
+# Operand order is kept for subtractions, a - c and c - a stay apart.
+if {$swapped != 2 * $single_difference} {
+    error "swapped_operations has $swapped adders, expected [expr {2 * $single_difference}]"
+}
+
+# Only nodes driven by the same nets port by port are merged, a + a is
+# not a + b.
+if {$subset != 2 * $single_sum} {
+    error "subset_operations has $subset adders, expected [expr {2 * $single_sum}]"
+}
@@ -0,0 +1,55 @@
+// Arithmetic duplicated on purpose: the cells are kept apart by running
+// the flow without opt_merge, so they reach parmys unmerged.
+
+module single_sum(a, b, sum);
+    input [7:0] a, b;
+    output [8:0] sum;
+
+    assign sum = a + b;
+endmodule
+
+module single_operations(a, b, c, sum, diff);
+    input [7:0] a, b, c;
+    output [8:0] sum;
+    output [8:0] diff;
+
+    assign sum = a + b;
+    assign diff = a - c;
+endmodule
+
+module duplicated_operations(a, b, c, sum1, sum2, diff1, diff2);
+    input [7:0] a, b, c;
+    output [8:0] sum1, sum2;
+    output [8:0] diff1, diff2;
+
+    // commutative duplicate and exact duplicate
+    assign sum1 = a + b;
+    assign sum2 = b + a;
+    assign diff1 = a - c;
+    assign diff2 = a - c;
+endmodule
+
+module single_difference(a, c, diff);
+    input [7:0] a, c;
+    output [8:0] diff;
+
+    assign diff = a - c;
+endmodule
+
+module swapped_operations(a, c, diff1, diff2);
+    input [7:0] a, c;
+    output [8:0] diff1, diff2;
+
+    // the same operands in the other order are a different subtraction
+    assign diff1 = a - c;
+    assign diff2 = c - a;
+endmodule
+
+module subset_operations(a, b, sum1, sum2);
+    input [7:0] a, b;
+    output [8:0] sum1, sum2;
+
+    // the second sum is driven by a subset of the drivers of the first
+    assign sum1 = a + b;
+    assign sum2 = a + a;
+endmodule
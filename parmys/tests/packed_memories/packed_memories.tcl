@@ -0,0 +1,50 @@
+yosys -import
+
+plugin -i parmys
+
+yosys -import
+
+# Return the number of cells of the given type left in the design.
+proc count_cells { type } {
+    set count_file [test_output_path "${type}.count"]
+    tee -q -o $count_file select -count t:$type
+    set fh [open $count_file r]
+    set text [read $fh]
+    close $fh
+
+    if {![regexp {(\d+) objects} $text -> count]} {
+        error "could not count the $type cells"
+    }
+    return $count
+}
+
+read_verilog -nomem2reg +/parmys/vtr_primitives.v
+
+setattr -mod -set keep_hierarchy 1 single_port_ram
+
+setattr -mod -set keep_hierarchy 1 dual_port_ram
+
+parmys_arch -a ../raygentop/k6_frac_N10_frac_chain_mem32K_40nm.xml
+
+read_verilog -sv -nolatches packed_memories.v
+
+hierarchy -check -top packed_memories
+
+procs -norom
+
+opt
+
+memory -nomap
+
+flatten
+
+parmys -a ../raygentop/k6_frac_N10_frac_chain_mem32K_40nm.xml -nopass
+
+# Both memories write 16 bit words, so each carries more than one write
+# enable pin into the packing.
+set dual_port [count_cells dual_port_ram]
+set single_port [count_cells single_port_ram]
+
+if {$dual_port != 1 || $single_port != 0} {
+    error "expected the memories stacked into 1 dual_port_ram, got $dual_port dual_port_ram and $single_port single_port_ram"
+}
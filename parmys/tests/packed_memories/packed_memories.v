@@ -0,0 +1,31 @@
+// Two small read-write memories of the same width and clock on their own
+// addresses, each taking only a part of a block ram. parmys stacks them
+// into the two halves of one dual port ram.
+module packed_memories(
+    input clk,
+    input we_a,
+    input [7:0] addr_a,
+    input [15:0] din_a,
+    output reg [15:0] dout_a,
+    input we_b,
+    input [7:0] addr_b,
+    input [15:0] din_b,
+    output reg [15:0] dout_b
+);
+
+    reg [15:0] mem_a [0:255];
+    reg [15:0] mem_b [0:255];
+
+    always @(posedge clk) begin
+        if (we_a)
+            mem_a[addr_a] <= din_a;
+        dout_a <= mem_a[addr_a];
+    end
+
+    always @(posedge clk) begin
+        if (we_b)
+            mem_b[addr_b] <= din_b;
+        dout_b <= mem_b[addr_b];
+    end
+
+endmodule
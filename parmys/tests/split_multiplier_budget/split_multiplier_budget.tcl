@@ -0,0 +1,54 @@
+yosys -import
+
+plugin -i parmys
+
+yosys -import
+
+# Map the design with the given extra parmys options and return the number
+# of hard multipliers left in it.
+proc count_multipliers { name options } {
+    design -reset
+
+    read_verilog -nomem2reg +/parmys/vtr_primitives.v
+
+    parmys_arch -a ../raygentop/k6_frac_N10_frac_chain_mem32K_40nm.xml
+
+    read_verilog -sv -nolatches split_multiplier_budget.v
+
+    hierarchy -check -top split_multiplier_budget
+
+    procs
+
+    flatten
+
+    parmys -a ../raygentop/k6_frac_N10_frac_chain_mem32K_40nm.xml -nopass {*}$options
+
+    set count_file [test_output_path "${name}.count"]
+    tee -q -o $count_file select -count t:multiply
+    set fh [open $count_file r]
+    set text [read $fh]
+    close $fh
+
+    if {![regexp {(\d+) objects} $text -> count]} {
+        error "could not count the multipliers of $name"
+    }
+    return $count
+}
+
+set fragments [count_multipliers unbudgeted {}]
+
+if {$fragments < 2} {
+    error "the multiplier was not split, it takes $fragments hard multipliers"
+}
+
+# The pieces of the split multiplier are allocated together: one hard
+# multiplier short of all of them, none of them goes to a hard block.
+set short [count_multipliers short [list -exact_mults [expr {$fragments - 1}]]]
+if {$short != 0} {
+    error "with a budget of [expr {$fragments - 1}] the multiplier takes $short hard multipliers, expected 0"
+}
+
+set exact [count_multipliers exact [list -exact_mults $fragments]]
+if {$exact != $fragments} {
+    error "with a budget of $fragments the multiplier takes $exact hard multipliers, expected $fragments"
+}
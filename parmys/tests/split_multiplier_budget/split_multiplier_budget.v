@@ -0,0 +1,11 @@
+// A multiplier wider than the hard block on both operands, split by
+// iterate_multipliers into several hard multipliers.
+module split_multiplier_budget(
+    input [71:0] a,
+    input [71:0] b,
+    output [143:0] out
+);
+
+    assign out = a * b;
+
+endmodule